@@ -0,0 +1,281 @@
+// Throughput benchmarks for building graphs and for the forward and backward engines.
+//
+// Every measurement is printed as one JSON object per line, so that results can be collected
+// and compared between commits. Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// Usage: bench [--min-nodes N] [--max-nodes N] [--reps N] [--warmup N] [--shape NAME] [--seed N]
+
+#include "DirectedGraph.h"
+#include "Scalar.h"
+#include "Unit.h"
+#include "operation_constants.h"
+#include "forwardProp.h"
+#include "backProp.h"
+#include "RandomGraph.h"
+#include "AllocationCounter.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    std::size_t minNodes{ 1000 };
+    std::size_t maxNodes{ 100000 };
+    std::size_t repetitions{ 10 };
+    std::size_t warmup{ 2 };
+    std::string shape{};          // Empty runs every shape.
+    std::uint64_t seed{ 1 };
+  };
+
+  /**
+   * @brief A graph together with the variables it points to.
+   */
+  struct Graph
+  {
+    DirectedGraph<Variable*> graph{};
+    std::vector<std::unique_ptr<Variable>> vars{};
+    Variable* output{};
+
+    Variable* keep(std::unique_ptr<Variable> var)
+    {
+      vars.push_back(std::move(var));
+      return vars.back().get();
+    }
+
+    Variable* leaf(const std::string& name, double value)
+    { return keep(std::make_unique<Scalar>(name, input, value)); }
+
+    /* Sums the variables pairwise into a single output. */
+    void reduce(std::vector<Variable*> level)
+    {
+      while (level.size() > 1) {
+	std::vector<Variable*> next{};
+	for (std::size_t i{0}; i + 1 < level.size(); i += 2)
+	  next.push_back(keep(scalarAdd(graph, *level[i], *level[i + 1])));
+	if (level.size() % 2 == 1)
+	  next.push_back(level.back());
+	level = std::move(next);
+      }
+      output = level.front();
+    }
+  };
+
+  /* x*c + c repeated, one long dependency chain. */
+  std::unique_ptr<Graph> buildChain(std::size_t nodes, std::uint64_t)
+  {
+    auto g{ std::make_unique<Graph>() };
+    Variable* v{ g->leaf("x", 0.5) };
+    Variable* c{ g->leaf("c", 1.0 - 1e-7) };
+    for (std::size_t i{0}; g->vars.size() < nodes; ++i)
+      v = g->keep((i % 2 == 0) ? scalarMul(g->graph, *v, *c) : scalarAdd(g->graph, *v, *c));
+    g->output = v;
+    return g;
+  }
+
+  /* v = v*c + v*c repeated, every variable has two consumers. */
+  std::unique_ptr<Graph> buildDiamonds(std::size_t nodes, std::uint64_t)
+  {
+    auto g{ std::make_unique<Graph>() };
+    Variable* v{ g->leaf("x", 0.5) };
+    Variable* c{ g->leaf("c", 0.5) };
+    while (g->vars.size() < nodes) {
+      Variable* left{ g->keep(scalarMul(g->graph, *v, *c)) };
+      Variable* right{ g->keep(scalarMul(g->graph, *v, *c)) };
+      v = g->keep(scalarAdd(g->graph, *left, *right));
+    }
+    g->output = v;
+    return g;
+  }
+
+  /* Half of the nodes are leafs which are summed into one output. */
+  std::unique_ptr<Graph> buildFanIn(std::size_t nodes, std::uint64_t)
+  {
+    auto g{ std::make_unique<Graph>() };
+    std::vector<Variable*> leafs{};
+    for (std::size_t i{0}; i < std::max<std::size_t>(nodes / 2, 2); ++i)
+      leafs.push_back(g->leaf("x" + std::to_string(i), 1.0 / (i + 1.0)));
+    g->reduce(std::move(leafs));
+    return g;
+  }
+
+  /* Layers of 64 random operations, the sinks summed into one output, see randomGraph. */
+  std::unique_ptr<Graph> buildRandom(std::size_t nodes, std::uint64_t seed)
+  {
+    RandomGraphOptions options{};
+    options.seed = seed;
+    options.inputs = 16;
+    options.width = 64;
+    options.depth = std::max<std::size_t>(nodes / options.width, 1);
+    options.singleOutput = true;
+    RandomGraph generated{ randomGraph<double>(options) };
+    auto g{ std::make_unique<Graph>() };
+    g->graph = std::move(generated.graph);
+    g->vars = std::move(generated.variables);
+    g->output = generated.outputs.front();
+    return g;
+  }
+
+  struct Shape
+  {
+    std::string name;
+    std::function<std::unique_ptr<Graph>(std::size_t, std::uint64_t)> build;
+  };
+
+  struct Result
+  {
+    std::vector<double> nanoseconds{};
+    AllocationStats allocations{};   // Summed over the repetitions, the peak is the largest.
+  };
+
+  /**
+   * @brief Runs a pass warmup times, then measures it. Whatever the pass returns is destroyed
+   *        after the clock is stopped.
+   */
+  template <typename Pass>
+  Result measure(const Options& options, Pass pass)
+  {
+    for (std::size_t i{0}; i < options.warmup; ++i)
+      pass();
+    Result result{};
+    for (std::size_t i{0}; i < options.repetitions; ++i) {
+      const AllocationScope scope{};
+      const auto start{ Clock::now() };
+      {
+	[[maybe_unused]] const auto kept{ pass() };
+	const auto stop{ Clock::now() };
+	const AllocationStats stats{ scope.stats() };
+	result.allocations.allocations += stats.allocations;
+	result.allocations.bytes += stats.bytes;
+	result.allocations.peakBytes = std::max(result.allocations.peakBytes, stats.peakBytes);
+	result.nanoseconds.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+      }
+    }
+    return result;
+  }
+
+  void report(const std::string& benchmark, const std::string& shape, std::size_t nodes,
+	      Result result)
+  {
+    auto& times{ result.nanoseconds };
+    std::sort(times.begin(), times.end());
+    const std::size_t n{ times.size() };
+    const double median{ (n % 2 == 1) ? times[n / 2] : 0.5 * (times[n / 2 - 1] + times[n / 2]) };
+    const std::size_t rank{ static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(n))) };
+    const double p99{ times[std::max<std::size_t>(rank, 1) - 1] };
+    std::cout << "{\"benchmark\":\"" << benchmark << "\",\"shape\":\"" << shape
+	      << "\",\"nodes\":" << nodes << ",\"repetitions\":" << n
+	      << ",\"median_ns\":" << static_cast<std::uint64_t>(median)
+	      << ",\"p99_ns\":" << static_cast<std::uint64_t>(p99)
+	      << ",\"min_ns\":" << static_cast<std::uint64_t>(times.front())
+	      << ",\"nodes_per_second\":" << static_cast<std::uint64_t>(nodes / (median * 1e-9))
+	      << ",\"allocations_per_pass\":" << result.allocations.allocations / n
+	      << ",\"bytes_per_pass\":" << result.allocations.bytes / n
+	      << ",\"peak_bytes\":" << result.allocations.peakBytes
+	      << ",\"threads\":" << ParallelOptions{}.concurrency()
+	      << ",\"build_type\":\"" << BENCH_BUILD_TYPE << "\"}" << std::endl;
+  }
+
+  void benchShape(const Shape& shape, std::size_t nodes, const Options& options)
+  {
+    const auto built{ shape.build(nodes, options.seed) };
+    const std::size_t size{ built->vars.size() };
+    report("graph_build", shape.name, size, measure(options, [&]() {
+      return shape.build(nodes, options.seed);
+    }));
+
+    // Graphs of at least ParallelOptions::threshold variables are handed to the global pool by
+    // both forwardProp and backProp_walk, so these rows measure the parallel engines at the
+    // default sizes whenever the pool has more than one thread, see the threads field.
+    const std::vector<Variable*> outputs{ built->output };
+    report("forward", shape.name, size, measure(options, [&]() {
+      forwardProp(built->graph, outputs);
+      return Scalar::value(*built->output);
+    }));
+    report("backward", shape.name, size, measure(options, [&]() {
+      return backProp_walk(built->graph, *built->output);
+    }));
+  }
+
+  /* A chain of scalar operations built through the Unit API, two variables per operation.
+     The lazy build only records the graph, see Unit::setLazyBuild. */
+  void benchUnit(std::size_t nodes, const Options& options)
+  {
+    auto build{ [nodes](bool lazy) {
+      auto unit{ std::make_unique<Unit>(Scalar{ "x", input, 0.5 }) };
+      unit->setLazyBuild(lazy);
+      for (std::size_t i{1}; i < nodes; i += 4)
+	unit->mul(1.0 - 1e-7).add(1e-7);
+      return unit;
+    }};
+    const std::size_t size{ build(false)->memoryUsage().nodes };
+    report("unit_build", "chain", size, measure(options, [&]() { return build(false); }));
+    report("unit_build_lazy", "chain", size, measure(options, [&]() { return build(true); }));
+  }
+
+  bool parse(int argc, char* argv[], Options& options)
+  {
+    for (int i{1}; i < argc; ++i) {
+      const std::string arg{ argv[i] };
+      if (i + 1 >= argc)
+	return false;
+      const std::string value{ argv[++i] };
+      if (arg == "--min-nodes")
+	options.minNodes = std::stoull(value);
+      else if (arg == "--max-nodes")
+	options.maxNodes = std::stoull(value);
+      else if (arg == "--reps")
+	options.repetitions = std::max<std::size_t>(std::stoull(value), 1);
+      else if (arg == "--warmup")
+	options.warmup = std::stoull(value);
+      else if (arg == "--shape")
+	options.shape = value;
+      else if (arg == "--seed")
+	options.seed = std::stoull(value);
+      else
+	return false;
+    }
+    // The sizes are multiplied by 10, so starting from 0 would never end.
+    return options.minNodes > 0;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  Options options{};
+  if (!parse(argc, argv, options)) {
+    std::cerr << "Usage: bench [--min-nodes N] [--max-nodes N] [--reps N] [--warmup N]"
+	      << " [--shape chain|diamond|fanin|random|unit] [--seed N]\n";
+    return 1;
+  }
+  const std::vector<Shape> shapes{
+    { "chain", buildChain },
+    { "diamond", buildDiamonds },
+    { "fanin", buildFanIn },
+    { "random", buildRandom } };
+  // Sizes are the minimum times the powers of ten up to the maximum, 10^3 to 10^5 by default.
+  for (std::size_t nodes{ options.minNodes }; nodes <= options.maxNodes; nodes *= 10) {
+    for (const Shape& shape : shapes)
+      if (options.shape.empty() || options.shape == shape.name)
+	benchShape(shape, nodes, options);
+    if (options.shape.empty() || options.shape == "unit")
+      benchUnit(nodes, options);
+  }
+  return 0;
+}
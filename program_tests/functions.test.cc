@@ -1,5 +1,7 @@
 #include "util.h"
+#include "SymbolTable.h"
 #include <cassert>
+#include <string>
 #include <iostream>
 
 void test_intersect() {
@@ -21,7 +23,27 @@ void test_intersect() {
   }
 }
 
+void test_symbols() {
+  const auto x{ SymbolTable::intern("x") };
+  assert(SymbolTable::intern(std::string{"x"}) == x);
+  assert(SymbolTable::intern("y") != x);
+  assert(SymbolTable::intern("") == 0);
+  assert(SymbolTable::name(x) == "x");
+  // Interning many names keeps earlier references valid.
+  const std::string& ref{ SymbolTable::name(x) };
+  for (int i{0}; i < 10000; ++i)
+    SymbolTable::intern("p" + std::to_string(i));
+  assert(&ref == &SymbolTable::name(x) && SymbolTable::size() >= 10003);
+  // Anonymous symbols are unique, unnamed and not stored.
+  const std::size_t size{ SymbolTable::size() };
+  const auto a{ SymbolTable::anonymous() };
+  assert(SymbolTable::isAnonymous(a) && !SymbolTable::isAnonymous(x));
+  assert(SymbolTable::anonymous() != a && SymbolTable::name(a).empty());
+  assert(SymbolTable::size() == size);
+}
+
 int main() {
   test_intersect();
+  test_symbols();
 }
 
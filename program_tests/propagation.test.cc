@@ -0,0 +1,646 @@
+
+#include "DirectedGraph.h"
+#include "Scalar.h"
+#include "operation_constants.h"
+#include "forwardProp.h"
+#include "backProp.h"
+#include "jacobian.h"
+#include "ThreadPool.h"
+#include "InferenceModel.h"
+#include "Profiler.h"
+#include "RandomGraph.h"
+#include "ExecutionContext.h"
+#include "Unit.h"
+#include "AllocationCounter.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+#include <unordered_map>
+
+using uvptr = std::unique_ptr<Variable>;
+
+static bool near(double v1, double v2, double eps=1e-9)
+{
+  return std::abs(v1 - v2) <= eps * std::max(1.0, std::abs(v2));
+}
+
+/**
+ * @brief A graph with two inputs and three outputs where one output is consumed by another.
+ *          a = x*y,  b = exp(a) + x,  c = log(b)/y
+ *        Outputs are {a, b, c}.
+ */
+struct MultiOutputGraph
+{
+  DirectedGraph<Variable*> graph{};
+  std::vector<uvptr> vars{};
+  Variable* x{};
+  Variable* y{};
+  Variable* a{};
+  Variable* b{};
+  Variable* c{};
+
+  Variable* keep(uvptr var)
+  {
+    vars.push_back(std::move(var));
+    return vars.back().get();
+  }
+
+  MultiOutputGraph(double xv, double yv)
+  {
+    x = keep(std::make_unique<Scalar>("x", input, xv));
+    y = keep(std::make_unique<Scalar>("y", input, yv));
+    a = keep(scalarMul(graph, *x, *y));
+    Variable* ea{ keep(scalarExp(graph, *a)) };
+    b = keep(scalarAdd(graph, *ea, *x));
+    Variable* lb{ keep(scalarLog(graph, *b)) };
+    c = keep(scalarDiv(graph, *lb, *y));
+  }
+};
+
+/**
+ * @brief Many independent branches reduced pairwise into a single output.
+ *          s = sum_i log(exp(x*c_i) + y),  c_i = 1/(i+1)
+ */
+struct WideGraph
+{
+  DirectedGraph<Variable*> graph{};
+  std::vector<uvptr> vars{};
+  Variable* x{};
+  Variable* y{};
+  Variable* s{};
+
+  Variable* keep(uvptr var)
+  {
+    vars.push_back(std::move(var));
+    return vars.back().get();
+  }
+
+  WideGraph(double xv, double yv, std::size_t branches)
+  {
+    x = keep(std::make_unique<Scalar>("x", input, xv));
+    y = keep(std::make_unique<Scalar>("y", input, yv));
+    std::vector<Variable*> level{};
+    for (std::size_t i{0}; i < branches; ++i)
+      {
+	Variable* c{ keep(std::make_unique<Scalar>("c" + std::to_string(i), input, 1.0/(i + 1.0))) };
+	Variable* xc{ keep(scalarMul(graph, *x, *c)) };
+	Variable* e{ keep(scalarExp(graph, *xc)) };
+	Variable* ey{ keep(scalarAdd(graph, *e, *y)) };
+	level.push_back(keep(scalarLog(graph, *ey)));
+      }
+    while (level.size() > 1)
+      {
+	std::vector<Variable*> next{};
+	for (std::size_t i{0}; i + 1 < level.size(); i += 2)
+	  next.push_back(keep(scalarAdd(graph, *level[i], *level[i + 1])));
+	if (level.size() % 2 == 1)
+	  next.push_back(level.back());
+	level = next;
+      }
+    s = level.front();
+  }
+
+  double expected(std::size_t branches) const
+  {
+    double sum{0};
+    for (std::size_t i{0}; i < branches; ++i)
+      sum += std::log(std::exp(Scalar::value(*x)/(i + 1.0)) + Scalar::value(*y));
+    return sum;
+  }
+};
+
+// The parallel tests get their own pool so that they use several threads on any machine.
+static ThreadPool pool{ 4 };
+
+static ParallelOptions onPool(std::size_t threshold, bool deterministic=false)
+{
+  return ParallelOptions{ 4, threshold, deterministic, &pool };
+}
+
+// Analytic Jacobian of (a, b, c) w.r.t. (x, y).
+static std::vector<std::vector<double>> analyticJacobian(double x, double y)
+{
+  const double e{ std::exp(x*y) };
+  const double b{ e + x };
+  return {
+    { y, x },
+    { y*e + 1.0, x*e },
+    { (y*e + 1.0)/(b*y), (x*e)/(b*y) - std::log(b)/(y*y) } };
+}
+
+void testMultiOutputForward()
+{
+  MultiOutputGraph g{1.0, 2.0};
+  Scalar::setValue(*g.x, 0.5);
+  Scalar::setValue(*g.y, 1.5);
+  // The intermediate output a has consumers, which forwardProp allows now.
+  forwardProp(g.graph, *g.a);
+  assert(near(Scalar::value(*g.a), 0.75));
+  forwardProp(g.graph, std::vector<Variable*>{g.a, g.c, g.b});
+  const double b{ std::exp(0.75) + 0.5 };
+  assert(near(Scalar::value(*g.b), b));
+  assert(near(Scalar::value(*g.c), std::log(b)/1.5));
+}
+
+void testVectorJacobianProduct()
+{
+  const double x{0.3}, y{1.7};
+  MultiOutputGraph g{x, y};
+  const auto J{ analyticJacobian(x, y) };
+  // One sweep with cotangents (u_a, u_b, u_c) gives u^T J.
+  const std::vector<double> u{ 0.5, -2.0, 3.0 };
+  auto grad_table{ backProp_vjp(g.graph, std::vector<Variable*>{g.a, g.b, g.c},
+				std::vector<Gradient>{ {u[0]}, {u[1]}, {u[2]} }) };
+  for (int j{0}; j < 2; ++j)
+    {
+      double expected{0.0};
+      for (int i{0}; i < 3; ++i)
+	expected += u[i] * J[i][j];
+      const double computed{ grad_table.at(j == 0 ? g.x : g.y)[0] };
+      std::cout << "vjp[" << j << "] = " << computed << " (" << expected << ")\n";
+      assert(near(computed, expected));
+    }
+  // Seeding a single output is just backProp_walk.
+  auto walk_table{ backProp_walk(g.graph, *g.c) };
+  assert(near(walk_table.at(g.x)[0], J[2][0]) && near(walk_table.at(g.y)[0], J[2][1]));
+}
+
+void testJacobianModes()
+{
+  const double x{0.3}, y{1.7};
+  MultiOutputGraph g{x, y};
+  const auto J{ analyticJacobian(x, y) };
+  const std::vector<Variable*> inputs{ g.x, g.y };
+  const std::vector<Variable*> outputs{ g.a, g.b, g.c };
+  for (auto mode : {JacobianMode::Automatic, JacobianMode::Forward, JacobianMode::Reverse})
+    {
+      const auto computed{ jacobian(g.graph, inputs, outputs, mode) };
+      assert(computed.size() == 3 && computed[0].size() == 2);
+      for (int i{0}; i < 3; ++i)
+	for (int j{0}; j < 2; ++j)
+	  assert(near(computed[i][j], J[i][j]));
+    }
+  // Repeated inputs, x*x, must count both edges in forward mode too.
+  DirectedGraph<Variable*> graph{};
+  auto z{ std::make_unique<Scalar>("z", input, 3.0) };
+  auto zz{ scalarMul(graph, *z, *z) };
+  const auto dz{ jacobian(graph, {z.get()}, {zz.get()}, JacobianMode::Forward) };
+  assert(near(dz[0][0], 6.0));
+}
+
+void testParallelForward()
+{
+  constexpr std::size_t branches{ 300 };
+  WideGraph g{0.5, 2.0, branches};
+  const ExecutionPlan<double> plan{ g.graph, {g.s} };
+  assert(plan.size() == g.vars.size());
+  forwardProp_parallel(plan, onPool(0));
+  assert(near(Scalar::value(*g.s), g.expected(branches)));
+
+  // Every intermediate agrees with the sequential engine.
+  std::vector<double> parallel{};
+  for (const auto& var : g.vars)
+    parallel.push_back(Scalar::value(*var));
+  Scalar::setValue(*g.x, -1.0);
+  forwardProp_parallel(plan, onPool(0));
+  assert(near(Scalar::value(*g.s), g.expected(branches)));
+  Scalar::setValue(*g.x, 0.5);
+  forwardProp(g.graph, *g.s);
+  for (std::size_t i{0}; i < g.vars.size(); ++i)
+    assert(Scalar::value(*g.vars[i]) == parallel[i]);
+
+  // Below the threshold the plan is evaluated on the calling thread.
+  Scalar::setValue(*g.y, 3.0);
+  forwardProp_parallel(plan, onPool(plan.size() + 1));
+  assert(near(Scalar::value(*g.s), g.expected(branches)));
+}
+
+void testParallelBackward()
+{
+  constexpr std::size_t branches{ 300 };
+  WideGraph g{0.5, 2.0, branches};
+  const ExecutionPlan<double> plan{ g.graph, {g.s} };
+  forwardProp_parallel(plan, onPool(0));
+  const std::vector<double> seed{ 1.0 };
+
+  // Agrees with the sequential walk for every variable.
+  const auto grad_table{ backProp_walk(g.graph, *g.s) };
+  const auto gradients{ backProp_parallel<double>(plan, seed, onPool(0)) };
+  assert(gradients.size() == plan.size());
+  for (std::size_t i{0}; i < plan.size(); ++i)
+    assert(near(gradients[i], grad_table.at(plan.getNodes()[i])[0], 1e-12));
+
+  double dx{0}, dy{0};
+  for (std::size_t i{0}; i < branches; ++i)
+    {
+      const double e{ std::exp(0.5/(i + 1.0)) };
+      dx += e/((i + 1.0)*(e + 2.0));
+      dy += 1.0/(e + 2.0);
+    }
+  const auto& nodes{ plan.getNodes() };
+  const std::size_t ix = std::find(nodes.begin(), nodes.end(), g.x) - nodes.begin();
+  const std::size_t iy = std::find(nodes.begin(), nodes.end(), g.y) - nodes.begin();
+  assert(near(gradients[ix], dx) && near(gradients[iy], dy));
+
+  // Deterministic summation gives bit-identical gradients on every run.
+  const ParallelOptions deterministic{4, 0, true};
+  const auto reference{ backProp_parallel<double>(plan, seed, deterministic) };
+  for (int run{0}; run < 10; ++run)
+    assert(backProp_parallel<double>(plan, seed, deterministic) == reference);
+  assert(near(reference[ix], dx) && near(reference[iy], dy));
+
+  // An output consumed by another output receives both its seed and its consumers' gradient.
+  MultiOutputGraph m{0.3, 1.7};
+  forwardProp(m.graph, *m.c);
+  const ExecutionPlan<double> multi{ m.graph, {m.a, m.c} };
+  const std::vector<double> cotangents{ 2.0, 1.0 };
+  const auto vjp{ backProp_vjp(m.graph, {m.a, m.c}, {{2.0}, {1.0}}) };
+  const auto parallel{ backProp_parallel<double>(multi, cotangents, onPool(0)) };
+  for (std::size_t i{0}; i < multi.size(); ++i)
+    assert(near(parallel[i], vjp.at(multi.getNodes()[i])[0]));
+}
+
+void testThreadPool()
+{
+  std::vector<int> calls(pool.size(), 0);
+  pool.run(pool.size(), [&](std::size_t id) { ++calls[id]; });
+  assert(std::all_of(calls.begin(), calls.end(), [](int c) { return c == 1; }));
+
+  // A job submitted from inside a job runs on the calling thread.
+  std::atomic<int> nested{0};
+  pool.run(4, [&](std::size_t) {
+    pool.run(4, [&](std::size_t id) { assert(id == 0); ++nested; });
+  });
+  assert(nested >= 1 && nested <= 4);
+
+  bool thrown{ false };
+  try
+    {
+      pool.run(4, [](std::size_t id) {
+	if (id == pool.size() - 1)
+	  throw BadWalkException("worker");
+      });
+    }
+  catch (const BadWalkException&)
+    {
+      thrown = true;
+    }
+  assert(thrown);
+
+  // A single threaded global pool still gives the same results, and large graphs go
+  // through the pool from the plain engines.
+  ThreadPool::configure(1);
+  assert(ThreadPool::global().size() == 1);
+  WideGraph g{0.5, 2.0, 400};
+  forwardProp(g.graph, std::vector<Variable*>{g.s});
+  assert(near(Scalar::value(*g.s), g.expected(400)));
+  ThreadPool::configure(3);
+  Scalar::setValue(*g.x, 0.25);
+  forwardProp(g.graph, std::vector<Variable*>{g.s});
+  assert(near(Scalar::value(*g.s), g.expected(400)));
+  const auto parallel{ backProp_walk(g.graph, *g.s) };
+  ThreadPool::configure(1);
+  const auto sequential{ backProp_walk(g.graph, *g.s) };
+  assert(parallel.size() == sequential.size());
+  for (const auto& [var, gradient] : sequential)
+    assert(near(parallel.at(var)[0], gradient[0], 1e-12));
+}
+
+void testConstantFolding()
+{
+  // With only x bound, y and everything computed from y alone are folded at freeze time.
+  MultiOutputGraph g{0.5, 2.0};
+  Variable* ey{ g.keep(scalarExp(g.graph, *g.y)) };
+  Variable* z{ g.keep(scalarMul(g.graph, *g.c, *ey)) };
+  forwardProp(g.graph, *z);
+  const ExecutionPlan<double> plan{ g.graph, {z, g.a}, {g.x} };
+  InferenceModel<double> model{ CompactGraph<double>{ plan } };
+  assert(model.getInputCount() == 1 && model.getConstantCount() == 2);   // y and exp(y)
+  assert(model.getInstructions().size() == 6);
+  for (const double x : {0.5, 1.5, -0.25}) {
+    const double in[] = {x};
+    model.forward(in);
+    Scalar::setValue(*g.x, x);
+    forwardProp(g.graph, *z);
+    assert(model.getOutput(0) == Scalar::value(*z) && model.getOutput(1) == Scalar::value(*g.a));
+  }
+}
+
+void testProfiler()
+{
+#if AUTODIFF_PROFILING
+  // d = c + c makes the recursive forwardProp walk the whole graph below c twice.
+  MultiOutputGraph g{0.5, 2.0};
+  Variable* d{ g.keep(scalarAdd(g.graph, *g.c, *g.c)) };
+  Profiler::reset();
+  forwardProp(g.graph, *d);
+  assert(Profiler::report().total(ProfilePhase::Forward).calls == 0);   // Off by default.
+
+  Profiler::enable();
+  forwardProp(g.graph, *d);
+  backProp_walk(g.graph, *d);
+  Profiler::disable();
+  const ProfileReport report{ Profiler::report() };
+  assert(report.getVisits(ProfilePhase::Forward) == 19);
+  assert(report.total(ProfilePhase::Forward).calls == 11);
+  assert(report.get(ProfilePhase::Forward, OpCode::ScalarDiv).calls == 2);
+  assert(report.get(ProfilePhase::Forward, OpCode::ScalarAdd).bytes == 3 * 3 * sizeof(double));
+  // The backward walk reaches every variable once and calls bprop once per operation.
+  assert(report.getVisits(ProfilePhase::Backward) == 8);
+  assert(report.total(ProfilePhase::Backward).calls == 6);
+  assert(report.get(ProfilePhase::Backward, OpCode::ScalarAdd).calls == 2);
+  assert(report.get(ProfilePhase::Backward, OpCode::Input).calls == 0);
+
+  // The ordered engine evaluates each variable once.
+  Profiler::reset();
+  Profiler::enable();
+  forwardProp(g.graph, std::vector<Variable*>{ d });
+  Profiler::disable();
+  assert(Profiler::report().total(ProfilePhase::Forward).calls == 6);
+  assert(Profiler::report().getVisits(ProfilePhase::Forward) == 8);
+  std::cout << Profiler::report();
+  Profiler::reset();
+#endif
+}
+
+void testTrace()
+{
+#if AUTODIFF_PROFILING
+  WideGraph g{0.5, 2.0, 64};
+  const ExecutionPlan<double> plan{ g.graph, {g.s} };
+  std::size_t computed{0};
+  for (std::size_t i{0}; i < plan.size(); ++i)
+    computed += plan.isLeaf(i) ? 0 : 1;
+  Profiler::clearTrace();
+  Profiler::startTrace();
+  forwardProp_parallel(plan, onPool(1));
+  const double seed[] = {1.0};
+  backProp_parallel<double>(plan, seed, onPool(1));
+  Profiler::stopTrace();
+  forwardProp_parallel(plan, onPool(1));   // Not recorded.
+
+  const auto events{ Profiler::traceEvents() };
+  assert(events.size() == 2 * computed);
+  const std::unordered_set<const void*> nodes(plan.getNodes().begin(), plan.getNodes().end());
+  for (std::size_t k{0}; k < events.size(); ++k) {
+    assert(nodes.count(reinterpret_cast<const void*>(events[k].node)) == 1);
+    assert(events[k].duration >= 0 && (k == 0 || events[k - 1].start <= events[k].start));
+  }
+  const auto forward{ std::count_if(events.begin(), events.end(), [](const TraceEvent& e) {
+    return e.phase == ProfilePhase::Forward;
+  }) };
+  assert(static_cast<std::size_t>(forward) == computed);
+
+  std::ostringstream json{};
+  Profiler::writeTrace(json);
+  const std::string text{ json.str() };
+  assert(text.rfind("{\"traceEvents\":[", 0) == 0);
+  std::size_t complete{0};
+  for (std::size_t at{ text.find("\"ph\":\"X\"") }; at != std::string::npos;
+       at = text.find("\"ph\":\"X\"", at + 1))
+    ++complete;
+  assert(complete == events.size());
+  assert(text.find("\"name\":\"ScalarExp\",\"cat\":\"forward\"") != std::string::npos);
+  Profiler::clearTrace();
+  assert(Profiler::traceEvents().empty());
+#endif
+}
+
+void testRandomGraphs()
+{
+  RandomGraphOptions options{};
+  options.seed = 7;
+  options.depth = 12;
+  options.width = 10;
+  options.inputs = 6;
+  options.maxFanOut = 4;
+  const RandomGraph g1{ randomGraph<double>(options) };
+  const RandomGraph g2{ randomGraph<double>(options) };
+  assert(g1.variables.size() == options.inputs + options.depth * options.width);
+  // The same seed gives the same graph.
+  for (std::size_t k{0}; k < g1.variables.size(); ++k) {
+    assert(g1.variables[k]->getOperation() == g2.variables[k]->getOperation());
+    assert(Scalar::value(*g1.variables[k]) == Scalar::value(*g2.variables[k]));
+  }
+  std::unordered_map<const Variable*, std::size_t> index{};
+  std::vector<std::size_t> consumers(g1.variables.size(), 0);
+  for (std::size_t k{0}; k < g1.variables.size(); ++k)
+    index[g1.variables[k].get()] = k;
+  for (std::size_t k{0}; k < g1.variables.size(); ++k) {
+    for (const Variable* arg : g1.graph.getNodeInputs(g1.variables[k].get())) {
+      assert(index.at(arg) < k);
+      ++consumers[index.at(arg)];
+    }
+  }
+  assert(*std::max_element(consumers.begin(), consumers.end()) <= options.maxFanOut);
+  for (const Variable* output : g1.outputs)
+    assert(consumers[index.at(output)] == 0);
+
+  // The engines agree on graphs of every seed.
+  for (std::uint64_t seed{1}; seed <= 6; ++seed) {
+    options = RandomGraphOptions{};
+    options.seed = seed;
+    options.depth = 6 + seed;
+    options.width = 3 * seed;
+    options.sharing = 0.1 * seed;
+    options.fanOutSkew = (seed % 2 == 0) ? 2.0 : 0.0;
+    options.singleOutput = true;
+    options.ops.push_back({ OpCode::ScalarExp, 0.1 });
+    RandomGraph g{ randomGraph<double>(options) };
+    assert(g.outputs.size() == 1);
+    Variable& out{ *g.outputs.front() };
+    forwardProp(g.graph, g.outputs);
+    const auto walked{ backProp_walk(g.graph, out) };
+    const auto plan{ std::make_shared<const ExecutionPlan<double>>(g.graph, g.outputs, g.inputs) };
+    ExecutionContext<double> context{ plan };
+    std::vector<double> values{};
+    for (const Variable* x : g.inputs)
+      values.push_back(Scalar::value(*x));
+    const auto gradient{ context.gradient(values) };
+    assert(context.getOutput(0) == Scalar::value(out));
+    const double seeds[] = {1.0};
+    const auto parallel{ backProp_parallel<double>(*plan, seeds, onPool(1, true)) };
+    for (std::size_t i{0}; i < g.inputs.size(); ++i) {
+      const auto it{ walked.find(g.inputs[i]) };
+      const double expected{ (it == walked.end()) ? 0.0 : it->second[0] };
+      assert(near(gradient[i], expected, 1e-12));
+    }
+    for (std::size_t i{0}; i < plan->size(); ++i)
+      assert(near(parallel[i], walked.at(plan->getNodes()[i])[0], 1e-12));
+
+    // The unit holds the same function.
+    Unit unit{ randomUnit<double>(options) };
+    std::vector<double> bound{};
+    for (const Variable* x : unit.getInputs())
+      bound.push_back(values.at(std::stoul(x->getName().substr(1))));
+    assert(near(unit.forward(bound), Scalar::value(out)));
+  }
+}
+
+void testAllocations()
+{
+  // This test is linked with the counting operator new.
+  assert(AllocationCounter::isInstalled());
+  {
+    const AllocationScope scope{};
+    { std::vector<char> block(1 << 20); }
+    const AllocationStats stats{ scope.stats() };
+    assert(stats.allocations == 1 && stats.deallocations == 1);
+    assert(stats.bytes == (1 << 20) && stats.peakBytes >= (1 << 20));
+  }
+
+  // The compiled engines do not allocate once set up.
+  MultiOutputGraph g{0.5, 2.0};
+  forwardProp(g.graph, *g.c);
+  const auto plan{ std::make_shared<const ExecutionPlan<double>>(
+    g.graph, std::vector<Variable*>{ g.c }, std::vector<Variable*>{ g.x, g.y }) };
+  ExecutionContext<double> context{ plan };
+  InferenceModel<double> model{ CompactGraph<double>{ *plan } };
+  const double inputs[] = {0.75, 1.5};
+  const double seed[] = {1.0};
+  {
+    const AllocationScope scope{};
+    for (int i{0}; i < 3; ++i) {
+      context.forward(inputs);
+      context.backward(seed);
+      model.forward(inputs);
+    }
+    assert(scope.stats().allocations == 0);
+  }
+
+  // The walk allocates its tables, but its bprop calls write into buffers on the stack.
+  Profiler::reset();
+  Profiler::enable();
+  {
+    const AllocationScope scope{};
+    backProp_walk(g.graph, *g.c);
+    assert(scope.stats().allocations > 0);
+  }
+  Profiler::disable();
+#if AUTODIFF_PROFILING
+  const ProfileReport report{ Profiler::report() };
+  assert(report.total(ProfilePhase::Backward).calls == 5);
+  assert(report.total(ProfilePhase::Backward).allocations == 0);
+#endif
+  Profiler::reset();
+}
+
+void testAdjointBprop()
+{
+  // The span bprop adds gradient * partial to the adjoints of all operands at once.
+  const double args[] = {0.7, 1.3};
+  for (std::size_t c{1}; c < ProfileReport::opCount; ++c) {
+    const Operation& operation{ operationOf<double>(static_cast<OpCode>(c)) };
+    const std::size_t arity{ operation.isBinary() ? 2u : 1u };
+    double adjoints[] = {0.5, -0.25};
+    operation.bprop({ args, arity }, operation.eval({ args, arity }), 2.0, { adjoints, arity });
+    assert(near(adjoints[0], 0.5 + 2.0 * operation.partial({ args, arity }, 0)));
+    if (arity == 2)
+      assert(near(adjoints[1], -0.25 + 2.0 * operation.partial({ args, arity }, 1)));
+  }
+  // Exp, Xpn and Div take their derivatives from the saved output instead of recomputing it.
+  double adjoint[] = {0.0};
+  scalarExp.bprop({ args, 1 }, 3.0, 1.0, { adjoint, 1 });
+  assert(adjoint[0] == 3.0);
+  // x^y at x = 0 cannot divide the output by x.
+  const double zero[] = {0.0, 1.0};
+  double powAdjoints[] = {0.0, 0.0};
+  scalarXpn.bprop({ zero, 2 }, scalarXpn.eval({ zero, 2 }), 1.0, { powAdjoints, 2 });
+  assert(powAdjoints[0] == 1.0);
+  // Nor when x^y under- or overflows, though x^(y-1) does not.
+  const auto& floatXpn{ basicScalarXpn<float> };
+  const float tiny[] = {1e-20f, 3.0f};
+  const float huge[] = {1e20f, 2.0f};
+  float floatAdjoints[] = {0.0f, 0.0f};
+  floatXpn.bprop({ tiny, 2 }, floatXpn.eval({ tiny, 2 }), 1.0f, { floatAdjoints, 2 });
+  assert(std::abs(floatAdjoints[0] - 3e-40f) < 1e-42f);
+  floatAdjoints[0] = 0.0f;
+  floatXpn.bprop({ huge, 2 }, floatXpn.eval({ huge, 2 }), 1.0f, { floatAdjoints, 2 });
+  assert(floatAdjoints[0] == 2e20f);
+  // Operands are told apart by position, so x - x has a zero gradient.
+  MultiOutputGraph g{0.5, 2.0};
+  Variable* d{ g.keep(scalarSub(g.graph, *g.c, *g.c)) };
+  Variable* q{ g.keep(scalarDiv(g.graph, *g.a, *g.a)) };
+  Variable* s{ g.keep(scalarAdd(g.graph, *d, *q)) };
+  forwardProp(g.graph, std::vector<Variable*>{ s });
+  const auto table{ backProp_walk(g.graph, *s) };
+  assert(table.at(g.x)[0] == 0.0 && table.at(g.y)[0] == 0.0);
+}
+
+void testValidation()
+{
+  // Compiling validates the graph once, the plan is then run without checks.
+  auto rejected{ [](const DirectedGraph<Variable*>& graph, Variable* output) {
+    try
+      {
+	const ExecutionPlan<double> plan{ graph, std::vector<Variable*>{ output } };
+      }
+    catch (const InvalidOperationException&)
+      {
+	return true;
+      }
+    return false;
+  }};
+  MultiOutputGraph g{0.5, 2.0};
+  assert(!rejected(g.graph, g.c));
+  // A binary operation with a single input.
+  Variable* half{ g.keep(std::make_unique<Scalar>(scalarAdd)) };
+  g.graph.addConnection(g.x, half);
+  assert(rejected(g.graph, half));
+  // An operation without inputs.
+  Variable* dangling{ g.keep(std::make_unique<Scalar>(scalarExp)) };
+  g.graph.addNode(dangling);
+  assert(rejected(g.graph, dangling));
+  // A cycle through two operations.
+  Variable* p{ g.keep(std::make_unique<Scalar>(scalarLog)) };
+  Variable* q{ g.keep(std::make_unique<Scalar>(scalarAbs)) };
+  g.graph.addNode(p);
+  g.graph.addConnection(p, q);
+  g.graph.addConnection(q, p);
+  assert(rejected(g.graph, q));
+
+  // The unchecked paths give the same values as the checked one.
+  MultiOutputGraph h{0.5, 2.0};
+  const std::vector<Variable*> outputs{ h.c };
+  forwardProp(h.graph, outputs);
+  const double expected{ Scalar::value(*h.c) };
+  forwardProp_parallel(ExecutionPlan<double>{ h.graph, outputs });
+  assert(Scalar::value(*h.c) == expected);
+  const auto order{ h.graph.topologicalOrder(outputs) };
+  for (Variable* var : order)
+    var->invalidate();
+  assert(forwardProp_incremental(h.graph, order) == 5);
+  assert(Scalar::value(*h.c) == expected);
+  // The backward walk checks its cotangents once instead of every node.
+  bool thrown{ false };
+  try { backProp_vjp(h.graph, outputs, { Gradient{ 1.0, 1.0 } }); }
+  catch (const InvalidOperationException&) { thrown = true; }
+  assert(thrown);
+}
+
+int main()
+{
+  testMultiOutputForward();
+  testVectorJacobianProduct();
+  testJacobianModes();
+  testParallelForward();
+  testParallelBackward();
+  testThreadPool();
+  testConstantFolding();
+  testProfiler();
+  testTrace();
+  testRandomGraphs();
+  testAllocations();
+  testAdjointBprop();
+  testValidation();
+  std::cout << "Propagation tests complete!\n";
+  return 0;
+}
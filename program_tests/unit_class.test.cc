@@ -3,14 +3,24 @@
 #include "Exceptions.h"
 #include "Scalar.h"
 #include "operation_constants.h"
+#include "MixedPrecision.h"
+#include "Optimizer.h"
+#include "ThreadPool.h"
+#include "ExecutionContext.h"
 
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <typeinfo>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <filesystem>
 
 #define VECTOR_TESTS 0
-#define FIXED_COPY_CONSTRUCTOR 0
+#define FIXED_COPY_CONSTRUCTOR 1
 
 using std::log, std::abs, std::pow, std::exp;
 using In = Unit;
@@ -151,18 +161,525 @@ void testBackprop() {
   }  
 }
 
+void testPrecisions() {
+  // The same function evaluated in float, double and long double should agree up to the
+  // precision of the smallest type.
+  auto build{ [](auto& fg) {
+    using U = std::remove_reference_t<decltype(fg)>;
+    using T = typename U::value_type;
+    fg.xpn(3)
+      .sub(U{BasicScalar<T>{"x"}}.xpn(2))
+      .add(U{BasicScalar<T>{"x"}}.log())
+      .div(5);
+  }};
+  BasicUnit<float> ff{BasicScalar<float>{"x"}};
+  BasicUnit<long double> fl{BasicScalar<long double>{"x"}};
+  Unit fd{Scalar{"x"}};
+  build(ff);
+  build(fd);
+  build(fl);
+  static_assert(std::is_same_v<decltype(ff.forward(1.0f)), float>);
+  static_assert(std::is_same_v<decltype(fl.backward(1.0L)), long double>);
+  for (const double x : values) {
+    const double scale{ std::max(1.0, std::abs(fd.forward(x))) };
+    const double gscale{ std::max(1.0, std::abs(fd.backward(x))) };
+    assert(std::abs(ff.forward(static_cast<float>(x)) - fd.forward(x)) < 1e-5 * scale);
+    assert(std::abs(ff.backward(static_cast<float>(x)) - fd.backward(x)) < 1e-5 * gscale);
+    assert(std::abs(static_cast<double>(fl.forward(x)) - fd.forward(x)) < 1e-12 * scale);
+    assert(std::abs(static_cast<double>(fl.backward(x)) - fd.backward(x)) < 1e-12 * gscale);
+  }
+}
+
+void testMixedPrecision() {
+  // Loss |w*x - t| trained with float compute and double master weights.
+  BasicUnit<float> loss{BasicScalar<float>{"x"}};
+  loss.mul(0.5f).sub(3.0f).abs();
+  MixedPrecisionTrainer trainer{loss, 0.01};
+  assert(trainer.getMasterWeights().size() == 2);
+  double first{ -1.0 };
+  for (int i{0}; i < 100; ++i) {
+    assert(trainer.step(2.0f));
+    if (first < 0.0)
+      first = trainer.getLoss();
+  }
+  assert(trainer.getLoss() < first && "Training should decrease the loss.");
+  assert(trainer.getLossScale() == 65536.0);
+
+  // A scale that overflows float must skip the step and back off.
+  BasicUnit<float> big{BasicScalar<float>{"x"}};
+  big.mul(0.5f).sub(3.0f).abs();
+  MixedPrecisionTrainer::LossScaling scaling{};
+  scaling.initialScale = 1e39;
+  MixedPrecisionTrainer overflow{big, 0.01, scaling};
+  const std::vector<double> before{ overflow.getMasterWeights() };
+  assert(!overflow.step(2.0f));
+  assert(overflow.getSkippedSteps() == 1 && overflow.getLossScale() == 0.5e39);
+  assert(overflow.getMasterWeights() == before);
+  while (!overflow.step(2.0f)) {}
+  assert(overflow.getLossScale() < 3.5e38);
+}
+
+void testOptimizers() {
+  // A single step of each update rule from w = (3, 1).
+  auto near = [](const std::vector<double>& w, double w0, double w1) {
+    return abs(w[0] - w0) < 1e-6 && abs(w[1] - w1) < 1e-6;
+  };
+  auto linear = []() {
+    Unit unit{Scalar{"x"}};
+    unit.mul(3.0).add(1.0);
+    return unit;
+  };
+  {
+    Unit unit{ linear() };
+    SGD sgd{unit, OptimizerOptions{ 0.5, 0.1 }};
+    const double g[] = {2.0, -4.0};
+    sgd.apply(g);   // Weight decay adds 0.1*w to the gradient.
+    assert(near(sgd.getWeights(), 3.0 - 0.5*2.3, 1.0 + 0.5*3.9) && sgd.getSteps() == 1);
+    // The new parameters are written into the unit.
+    equals(unit.forward(2.0), 2.0*1.85 + 2.95, 2.0);
+  }
+  {
+    Unit unit{ linear() };
+    SGD clipped{unit, OptimizerOptions{ 0.5, 0.0, 1.0 }};
+    const double g[] = {2.0, -4.0};
+    clipped.apply(g);
+    assert(near(clipped.getWeights(), 2.5, 1.5));
+  }
+  {
+    Unit unit{ linear() };
+    SGD normed{unit, OptimizerOptions{ 1.0, 0.0, 0.0, 1.0 }};
+    const double g[] = {3.0, 4.0};
+    normed.apply(g);   // The norm 5 is scaled down to 1.
+    assert(near(normed.getWeights(), 2.4, 0.2));
+  }
+  {
+    Unit unit{ linear() };
+    Momentum momentum{unit, OptimizerOptions{ 0.1 }, 0.9};
+    const double g[] = {1.0, 1.0};
+    momentum.apply(g);
+    momentum.apply(g);
+    assert(near(momentum.getWeights(), 3.0 - 0.1 - 0.19, 1.0 - 0.1 - 0.19));
+  }
+  {
+    Unit unit{ linear() };
+    RMSProp rmsprop{unit, OptimizerOptions{ 0.1 }, 0.9};
+    const double g[] = {2.0, -4.0};
+    rmsprop.apply(g);   // The first step is learningRate/sqrt(1 - decay) times the sign.
+    assert(near(rmsprop.getWeights(), 3.0 - 0.1/std::sqrt(0.1), 1.0 + 0.1/std::sqrt(0.1)));
+  }
+  {
+    Unit unit{ linear() };
+    Adam adam{unit, OptimizerOptions{ 0.1 }};
+    const double g[] = {2.0, -4.0};
+    adam.apply(g);   // The bias corrected first step is the learning rate times the sign.
+    assert(near(adam.getWeights(), 2.9, 1.1));
+  }
+
+  // Training the loss (w*x + b)^2. The clone has leafs of the same names, so the parameters
+  // are shared by both factors.
+  auto train = [&](BasicOptimizer<double>& optimizer) {
+    const double x[] = {1.0};
+    const double first{ optimizer.step(x) };
+    double last{ first };
+    for (int i{0}; i < 200; ++i)
+      last = optimizer.step(x);
+    return first > 10.0 && last < 1e-3 * first;
+  };
+  auto square = [&]() {
+    Unit loss{ linear() };
+    loss.mul(loss.clone());
+    assert(loss.getParameters().size() == 2);
+    return loss;
+  };
+  Unit sgdLoss{ square() };
+  SGD sgd{sgdLoss, OptimizerOptions{ 0.05 }};
+  assert(train(sgd));
+  Unit momentumLoss{ square() };
+  Momentum momentum{momentumLoss, OptimizerOptions{ 0.02 }};
+  assert(train(momentum));
+  Unit rmspropLoss{ square() };
+  RMSProp rmsprop{rmspropLoss, OptimizerOptions{ 0.02 }};
+  assert(train(rmsprop));
+  Unit adamLoss{ square() };
+  Adam adam{adamLoss, OptimizerOptions{ 0.1 }};
+  assert(train(adam));
+
+  // Large units are updated in chunks on several threads with the same result.
+  Unit wide{Scalar{"x"}};
+  for (int i{0}; i < 5000; ++i)
+    wide.mul(1.0).add(0.0);
+  Unit copy{ wide.clone() };
+  static ThreadPool pool{4};
+  OptimizerOptions threaded{ 0.01, 0.01, 0.5, 10.0 };
+  threaded.parallel = ParallelOptions{ 4, 1, false, &pool };
+  OptimizerOptions serial{ threaded };
+  serial.parallel.threads = 1;
+  Adam parallelAdam{wide, threaded};
+  Adam serialAdam{copy, serial};
+  assert(parallelAdam.getWeights().size() == 10000);
+  const double x[] = {0.999};
+  for (int i{0}; i < 3; ++i) {
+    const double l1{ parallelAdam.step(x) };
+    const double l2{ serialAdam.step(x) };
+    assert(l1 == l2);
+  }
+  assert(parallelAdam.getWeights() == serialAdam.getWeights());
+  assert(parallelAdam.getWeights() != std::vector<double>(10000, 0.0));
+}
+
+void testMultiInput() {
+  // f(x, y, z) = x*y + log(x)/y - z
+  auto f{ [](double x, double y, double z) { return x*y + log(x)/y - z; } };
+  Unit fg{Scalar{"x"}};
+  fg.mul(Unit{Scalar{"y"}})
+    .add(Unit{Scalar{"x"}}.log().div(Unit{Scalar{"y"}}))
+    .sub(Unit{Scalar{"z"}});
+  // The leafs of the other unit appear in a different order than in this one.
+  fg.mul(Unit{Scalar{"y"}}.div(Unit{Scalar{"x"}}).mul(Unit{Scalar{"y"}}).div(5.0)
+	 .mul(Unit{Scalar{"x"}}));
+  auto g{ [&f](double x, double y, double z) { return f(x, y, z) * y*y/5.0; } };
+  assert(fg.getInputs().size() == 3);
+  assert(fg.getInputs()[0]->getName() == "x" && fg.getInputs()[1]->getName() == "y"
+	 && fg.getInputs()[2]->getName() == "z");
+  for (const double x : values) {
+    const double y{ x/3.0 + 1.0 };
+    const double z{ 2.0*x };
+    const double in[] = {x, y, z};
+    equals(fg.forward(in), g(x, y, z), x);
+    // Compare with central differences.
+    const auto grad{ fg.gradient(in) };
+    assert(grad.size() == 3);
+    constexpr double h{1e-6};
+    const double numeric[] = {
+      (g(x + h, y, z) - g(x - h, y, z))/(2*h),
+      (g(x, y + h, z) - g(x, y - h, z))/(2*h),
+      (g(x, y, z + h) - g(x, y, z - h))/(2*h) };
+    for (int i{0}; i < 3; ++i)
+      assert(abs(grad[i] - numeric[i]) < 1e-4 * std::max(1.0, abs(numeric[i])));
+  }
+  bool thrown{ false };
+  try {
+    const double in[] = {1.0, 2.0};
+    fg.forward(in);
+  } catch (const InvalidOperationException&) {
+    thrown = true;
+  }
+  assert(thrown && "Binding too few inputs should throw.");
+}
+
+void testIncrementalForward() {
+  // f(x, y, z) = abs(x)*y + log(z)
+  auto f{ [](double x, double y, double z) { return abs(x)*y + log(z); } };
+  Unit fg{Scalar{"x"}};
+  fg.abs().mul(Unit{Scalar{"y"}}).add(Unit{Scalar{"z"}}.log());
+  const double in1[] = {2.0, 3.0, 4.0};
+  equals(fg.forward(in1), f(2.0, 3.0, 4.0), 2.0);
+  assert(fg.getRecomputed() == 4 && "The first pass computes every operation.");
+  // Nothing changed.
+  equals(fg.forward(in1), f(2.0, 3.0, 4.0), 2.0);
+  assert(fg.getRecomputed() == 0);
+  // Only z changed: log(z) and the sum.
+  const double in2[] = {2.0, 3.0, 5.0};
+  equals(fg.forward(in2), f(2.0, 3.0, 5.0), 2.0);
+  assert(fg.getRecomputed() == 2);
+  // abs(-2) == abs(2) so the cutoff stops the recomputation after abs.
+  const double in3[] = {-2.0, 3.0, 5.0};
+  equals(fg.forward(in3), f(-2.0, 3.0, 5.0), -2.0);
+  assert(fg.getRecomputed() == 1);
+  // Without cutoff the whole cone of x is recomputed.
+  fg.setEarlyCutoff(false);
+  const double in4[] = {2.0, 3.0, 5.0};
+  equals(fg.forward(in4), f(2.0, 3.0, 5.0), 2.0);
+  assert(fg.getRecomputed() == 3);
+  // Gradients of the incrementally updated unit are still correct.
+  const double in5[] = {2.0, 7.0, 5.0};
+  const auto grad{ fg.gradient(in5) };
+  assert(fg.getRecomputed() == 2);
+  assert(abs(grad[0] - 7.0) < 1e-12 && abs(grad[1] - 2.0) < 1e-12 && abs(grad[2] - 0.2) < 1e-12);
+  // Growing the unit recomputes the new operations only.
+  fg.exp();
+  equals(fg.forward(in5), exp(f(2.0, 7.0, 5.0)), 2.0);
+  assert(fg.getRecomputed() == 1);
+}
+
+void testLazyBuild() {
+  // f(x, y, z) = abs(x)*y + log(z), built without computing any value.
+  auto f{ [](double x, double y, double z) { return abs(x)*y + log(z); } };
+  Unit fg{Scalar{"x", input, 2.0}};
+  fg.setLazyBuild(true);
+  Unit z{Scalar{"z", input, 4.0}};
+  z.setLazyBuild(true);
+  fg.abs().mul(Unit{Scalar{"y", input, 3.0}}).add(z.log());
+  assert(Scalar::value(fg.getOutput()) == 0.0 && "Nothing is computed while building.");
+  const double in1[] = {2.0, 3.0, 4.0};
+  assert(abs(fg.forward(in1) - f(2.0, 3.0, 4.0)) < 1e-12);
+  assert(fg.getRecomputed() == 4);
+  // Lazily added operations are computed by the next pass, also through gradient.
+  fg.mul(2.0);
+  const double in2[] = {-2.0, 3.0, 4.0};
+  const auto grad{ fg.gradient(in2) };
+  assert(fg.getRecomputed() == 2 && "abs, cut off since abs(-2) == abs(2), and the new mul.");
+  assert(abs(Scalar::value(fg.getOutput()) - 2.0*f(-2.0, 3.0, 4.0)) < 1e-12);
+  assert(abs(grad[0] + 6.0) < 1e-12 && abs(grad[1] - 4.0) < 1e-12 && abs(grad[2] - 0.5) < 1e-12);
+}
+
+void testConcurrentContexts() {
+  // f(x, y) = exp(x*y)/(x + 2) - |y|^x
+  Unit fg{Scalar{"x"}};
+  fg.mul(Unit{Scalar{"y"}}).exp().div(Unit{Scalar{"x"}}.add(2.0))
+    .sub(Unit{Scalar{"y"}}.abs().xpn(Unit{Scalar{"x"}}));
+  // Reference values from the unit itself, computed before any thread starts.
+  std::vector<double> outputs{};
+  std::vector<std::vector<double>> gradients{};
+  for (const double x : values) {
+    const double in[] = {x/4.0, 1.0 - x/8.0};
+    outputs.push_back(fg.forward(in));
+    gradients.push_back(fg.gradient(in));
+  }
+  const auto plan{ fg.compile() };
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads{};
+  for (int t{0}; t < 8; ++t) {
+    threads.emplace_back([&]() {
+      ExecutionContext<double> context{ plan };
+      for (int repeat{0}; repeat < 50; ++repeat) {
+	for (std::size_t i{0}; i < std::size(values); ++i) {
+	  const double in[] = {values[i]/4.0, 1.0 - values[i]/8.0};
+	  const auto grad{ context.gradient(in) };
+	  if (abs(context.getOutput() - outputs[i]) > 1e-12 * std::max(1.0, abs(outputs[i])))
+	    ++mismatches;
+	  for (std::size_t k{0}; k < grad.size(); ++k)
+	    if (abs(grad[k] - gradients[i][k]) > 1e-12 * std::max(1.0, abs(gradients[i][k])))
+	      ++mismatches;
+	}
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  assert(mismatches == 0);
+  std::cout << "Concurrent contexts agree with the unit\n";
+}
+
+void testManySharedLeafs() {
+  // f = sum_i x_i and g = sum_i x_i^2 share all their inputs by name.
+  constexpr int n{ 500 };
+  auto sum{ [](int power) {
+    Unit u{Scalar{"x0"}};
+    if (power == 2) u.mul(Unit{Scalar{"x0"}});
+    for (int i{1}; i < n; ++i) {
+      Unit term{Scalar{"x" + std::to_string(i)}};
+      if (power == 2) term.mul(Unit{Scalar{"x" + std::to_string(i)}});
+      u.add(std::move(term));
+    }
+    return u;
+  }};
+  Unit f{ sum(1) };
+  f.add(sum(2));
+  assert(f.getInputs().size() == n);
+  std::vector<double> in(n);
+  for (int i{0}; i < n; ++i)
+    in[i] = i/double(n);
+  const auto grad{ f.gradient(in) };
+  for (int i{0}; i < n; ++i)
+    assert(abs(grad[i] - (1.0 + 2.0*in[i])) < 1e-12);
+}
+
+void testChainedJoin() {
+  // 300 layers h -> log(exp(1.01*h) + 0.1), each a unit with its own parameters.
+  constexpr int layers{ 300 };
+  std::vector<Unit> chain{};
+  for (int i{0}; i < layers; ++i) {
+    chain.emplace_back(Scalar{"h"});
+    chain.back().mul(1.01).exp().add(0.1).log();
+  }
+  Unit net{Scalar{"x"}};
+  net.join(std::span<Unit>{ chain });
+  assert(net.getInputs().size() == 1 && net.getParameters().size() == 2*layers);
+  double h{ 0.3 }, dh{ 1.0 };
+  for (int i{0}; i < layers; ++i) {
+    const double e{ std::exp(1.01*h) };
+    dh *= 1.01*e/(e + 0.1);
+    h = std::log(e + 0.1);
+  }
+  const double in[] = {0.3};
+  assert(abs(net.forward(in) - h) < 1e-9*abs(h));
+  assert(abs(net.gradient(in)[0] - dh) < 1e-9*abs(dh));
+}
+
+void testMultiInputJoin() {
+  // (x*y) joined into u + y + z, where y is shared by both units and z is new.
+  Unit a{Scalar{"x"}};
+  a.mul(Unit{Scalar{"y"}});
+  Unit b{Scalar{"u"}};
+  b.add(Unit{Scalar{"y"}}).add(Unit{Scalar{"z"}});
+  a.join(b);
+  const auto& inputs{ a.getInputs() };
+  assert(inputs.size() == 3 && inputs[0]->getName() == "x" && inputs[1]->getName() == "y"
+	 && inputs[2]->getName() == "z");
+  const double in[] = {2.0, 3.0, 0.5};
+  equals(a.forward(in), 2.0*3.0 + 3.0 + 0.5, 2.0);
+  const auto grad{ a.gradient(in) };
+  assert(grad[0] == 3.0 && grad[1] == 3.0 && grad[2] == 1.0);
+}
+
+void testCompactGraph() {
+  Unit f{Scalar{"x"}};
+  f.mul(Unit{Scalar{"y"}}).exp().div(Unit{Scalar{"x"}}.add(2.0))
+    .sub(Unit{Scalar{"y"}}.abs().xpn(Unit{Scalar{"x"}}));
+  auto compact{ f.compact() };
+  for (const double x : values) {
+    const double in[] = {x/4.0, 1.0 - x/8.0};
+    compact.forward(in);
+    assert(compact.getOutput() == f.forward(in));
+  }
+  assert(compact.size() == f.compile()->size());
+  const auto& nodes{ compact.getNodes() };
+  assert(nodes[compact.getBoundInputs()[0]].name == SymbolTable::intern("x"));
+
+  const MemoryUsage usage{ f.memoryUsage() };
+  const MemoryUsage packed{ compact.memoryUsage() };
+  std::cout << "Unit: " << usage << "\nCompact: " << packed << '\n';
+  assert(packed.bytesPerNode() < 32.0 && usage.bytesPerNode() > 100.0);
+}
+
+void testFrozenModel() {
+  // A deep chain: the frozen model needs only a handful of registers.
+  Unit f{Scalar{"x"}};
+  f.mul(Unit{Scalar{"y"}});
+  for (int i{0}; i < 50; ++i)
+    f.mul(0.9).add(Unit{Scalar{"y"}}.abs()).log().add(1.0);
+  auto model{ f.freeze() };
+  assert(model.getInputCount() == 2 && model.getConstantCount() == 100);
+  assert(model.getScratchSize() <= 2);
+  for (const double x : values) {
+    const double in[] = {x, 1.0 + x/8.0};
+    assert(model.forward(in) == f.forward(in));
+  }
+  assert(model.memoryUsage().bytes * 10 < f.memoryUsage().bytes);
+}
+
+void testSaveLoad() {
+  Unit f{Scalar{"x"}};
+  f.mul(Unit{Scalar{"y"}}).exp().div(Unit{Scalar{"x"}}.add(2.0))
+    .sub(Unit{Scalar{"y"}}.abs().xpn(Unit{Scalar{"x"}})).mul(0.5);
+  const auto path{ (std::filesystem::temp_directory_path() / "unit_class_test.graph").string() };
+  f.save(path);
+
+  // The mapped file is evaluated in place.
+  const auto mapped{ MappedGraph<double>::open(path) };
+  assert(mapped.verify() && mapped.size() == f.compile()->size());
+  assert(mapped.getName(mapped.getBoundInputs()[1]) == "y");
+  std::vector<double> scratch(mapped.size());
+  Unit g{ Unit::load(path) };
+  assert(g.getInputs().size() == 2 && g.getInputs()[0]->getName() == "x");
+  for (const double x : values) {
+    const double in[] = {x/4.0, 1.0 - x/8.0};
+    const double expected{ f.forward(in) };
+    assert(mapped.forward(in, scratch) == expected);
+    assert(g.forward(in) == expected);
+    assert(g.gradient(in) == f.gradient(in));
+  }
+
+  // The parameters of a loaded unit do not share names with any other parameter, i.e. with
+  // those of a unit built in another run, so they are never merged with them.
+  Unit twice{Scalar{"x"}};
+  twice.mul(2.0);
+  twice.save(path);
+  BasicScalar<double>::setValue(*twice.getParameters().front(), 5.0);
+  twice.add(Unit::load(path));
+  assert(twice.getParameters().size() == 2);
+  equals(twice.forward(3.0), 21.0, 3.0);
+  Unit both{ Unit::load(path) };
+  both.add(Unit::load(path));
+  assert(both.getParameters().size() == 2 && both.getInputs().size() == 1);
+  equals(both.forward(3.0), 12.0, 3.0);
+
+  // Units loaded on several threads at once still get parameters of their own.
+  std::vector<Unit> loaded{};
+  loaded.reserve(4);
+  for (int i{0}; i < 4; ++i)
+    loaded.emplace_back(Scalar{"x"});
+  {
+    std::vector<std::thread> loaders{};
+    for (int i{0}; i < 4; ++i)
+      loaders.emplace_back([&loaded, &path, i]() { loaded[i] = Unit::load(path); });
+    for (std::thread& loader : loaders)
+      loader.join();
+  }
+  for (int i{1}; i < 4; ++i)
+    loaded[0].add(loaded[i]);
+  assert(loaded[0].getParameters().size() == 4);
+  assert(abs(loaded[0].forward(3.0) - 24.0) < 1e-12);
+
+  // Parameters do not enter the symbol table, so loading and building units does not grow it.
+  const std::size_t symbols{ SymbolTable::size() };
+  for (int i{0}; i < 100; ++i) {
+    Unit again{ Unit::load(path) };
+    again.add(1.0).mul(2.0);
+  }
+  assert(SymbolTable::size() == symbols);
+
+  // A graph without bound inputs gives a unit without inputs, which has no first input.
+  std::vector<CompactNode> constant(2);
+  constant[1].inputs[0] = 0;
+  constant[1].opcode = OpCode::ScalarExp;
+  Unit closed{ CompactGraph<double>{ constant, {0.0, 1.0}, {1}, {} } };
+  assert(closed.getInputs().empty() && closed.getParameters().size() == 1);
+  bool noInput{ false };
+  try { closed.forward(1.0); } catch (const InvalidOperationException&) { noInput = true; }
+  assert(noInput);
+
+  // Files that do not verify are refused, i.e. a node reading a later node.
+  const SymbolTable::Symbol x{ SymbolTable::intern("x") };
+  std::vector<CompactNode> nodes(3);
+  nodes[0].name = x;
+  nodes[1].inputs[0] = 2;
+  nodes[1].opcode = OpCode::ScalarExp;
+  saveGraph(CompactGraph<double>{ nodes, {1.0, 0.0, 1.0}, {1}, {0} }, path);
+  bool thrown{ false };
+  try { Unit::load(path); } catch (const InvalidOperationException&) { thrown = true; }
+  assert(thrown);
+  f.save(path);
+
+  // Other precisions and damaged files are refused.
+  thrown = false;
+  try { MappedGraph<float>::open(path); } catch (const InvalidOperationException&) { thrown = true; }
+  assert(thrown);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  thrown = false;
+  try { MappedGraph<double>::open(path); } catch (const InvalidOperationException&) { thrown = true; }
+  assert(thrown);
+  std::filesystem::remove(path);
+}
+
 #if FIXED_COPY_CONSTRUCTOR
 void testConstructFromRef()
 {
-  // Turns out that the unique ptrs stored in the vector of Unit causes issues.
-  // TODO Implement the rule of three, i.e. copy constructor, copy assignment and destructor.
   Unit u{Scalar{"x", input, 2.0}};
-  u.add(2);
-  Unit new_u{u};             // Copy will cause crash
-  Unit new_u{std::move(u)};  // This will work though
+  u.add(2).mul(Unit{Scalar{"y"}}).exp();
+  const double in[] = {0.5, 0.25};
+  const double expected{ std::exp((0.5 + 2.0)*0.25) };
+  equals(u.forward(in), expected, 0.5);
+  Unit new_u{u};             // Deep copy of the variables and the graph.
+  // The copy keeps the values, so the same inputs do not recompute anything.
+  equals(new_u.forward(in), expected, 0.5);
+  assert(new_u.getRecomputed() == 0);
+  // The copy and the original are independent.
+  const double other[] = {1.0, 2.0};
+  equals(new_u.forward(other), std::exp(6.0), 1.0);
+  assert(BasicScalar<double>::value(u.getOutput()) == expected);
+  const auto grad{ new_u.gradient(other) };
+  equals(grad[0], 2.0*std::exp(6.0), 1.0);
+  equals(grad[1], 3.0*std::exp(6.0), 1.0);
+  equals(u.gradient(in)[1], 2.5*expected, 0.5);
 
-  // In fact any copy of a class that wraps a unique_ptr will cause issues.
-  // Hence we may want to create copy constructors for all Variable-s. 
+  Unit moved_u{std::move(u)};
+  equals(moved_u.forward(other), std::exp(6.0), 1.0);
+  Unit assigned{Scalar{"z"}};
+  assigned = new_u.clone();
+  equals(assigned.forward(in), expected, 0.5);
+  assert(assigned.getInputs()[0] != new_u.getInputs()[0]);
 }
 #endif
 
@@ -193,5 +710,19 @@ int main() {
   testMultiUnit();
   testJoiningUnits();
   testBackprop(); 
+  testPrecisions();
+  testMixedPrecision();
+  testOptimizers();
+  testMultiInput();
+  testIncrementalForward();
+  testLazyBuild();
+  testConcurrentContexts();
+  testConstructFromRef();
+  testManySharedLeafs();
+  testChainedJoin();
+  testMultiInputJoin();
+  testCompactGraph();
+  testFrozenModel();
+  testSaveLoad();
   std::cout << "Test Complete!\n";
 }
@@ -0,0 +1,137 @@
+// Accounting of heap allocations, i.e. to check that a pass does not allocate.
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * @brief Heap allocations over some span of time, see AllocationScope.
+ * @param bytes The bytes requested by the allocations.
+ * @param peakBytes The largest number of bytes live at once, above those live at the start.
+ */
+struct AllocationStats
+{
+  std::uint64_t allocations{ 0 };
+  std::uint64_t deallocations{ 0 };
+  std::uint64_t bytes{ 0 };
+  std::uint64_t peakBytes{ 0 };
+
+  friend std::ostream& operator<<(std::ostream& out, const AllocationStats& stats)
+  {
+    out << stats.allocations << " allocations, " << stats.deallocations << " deallocations, "
+	<< stats.bytes << " bytes, " << stats.peakBytes << " peak bytes";
+    return out;
+  }
+};
+
+/**
+ * Nothing is counted unless the replacement of the global operator new and delete in
+ * CountingNew.cc is linked into the executable, i.e. with
+ * target_link_libraries(target lib_CountingNew). Every allocation of the process is then
+ * counted, those of the standard containers in the graph, units and gradients included.
+ * @brief Process wide allocation counters.
+ */
+class AllocationCounter
+{
+private:
+  using Counter = std::atomic<std::uint64_t>;
+
+  inline static std::atomic<bool> s_installed{ false };
+  inline static Counter s_allocations{ 0 };
+  inline static Counter s_deallocations{ 0 };
+  inline static Counter s_bytes{ 0 };
+  inline static Counter s_live{ 0 };
+  inline static Counter s_peak{ 0 };
+  inline static thread_local std::uint64_t t_allocations{ 0 };
+
+public:
+  /**
+   * @brief Called once by the counting operator new, before main.
+   */
+  static void install() noexcept
+  { s_installed.store(true, std::memory_order_relaxed); }
+
+  /**
+   * @brief Whether allocations are counted at all.
+   */
+  static bool isInstalled() noexcept
+  { return s_installed.load(std::memory_order_relaxed); }
+
+  static void allocated(std::size_t bytes) noexcept
+  {
+    ++t_allocations;
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    s_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    const std::uint64_t live{ s_live.fetch_add(bytes, std::memory_order_relaxed) + bytes };
+    std::uint64_t peak{ s_peak.load(std::memory_order_relaxed) };
+    while (live > peak && !s_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+      ;
+  }
+
+  static void deallocated(std::size_t bytes) noexcept
+  {
+    s_deallocations.fetch_add(1, std::memory_order_relaxed);
+    s_live.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief The counts since the start of the process, the peak since the last resetPeak.
+   */
+  static AllocationStats total() noexcept
+  {
+    return AllocationStats{ s_allocations.load(std::memory_order_relaxed),
+			    s_deallocations.load(std::memory_order_relaxed),
+			    s_bytes.load(std::memory_order_relaxed),
+			    s_peak.load(std::memory_order_relaxed) };
+  }
+
+  static std::uint64_t liveBytes() noexcept
+  { return s_live.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief The allocations made by the calling thread, unaffected by other threads.
+   */
+  static std::uint64_t threadAllocations() noexcept
+  { return t_allocations; }
+
+  /**
+   * @brief Starts a new peak from the bytes live now.
+   */
+  static void resetPeak() noexcept
+  { s_peak.store(s_live.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+};
+
+/**
+ * Scopes should not overlap, since each one restarts the peak. The counts include the
+ * allocations of other threads during the scope, i.e. those of the thread pool.
+ * @brief Measures the allocations from construction to a call to stats.
+ */
+class AllocationScope
+{
+private:
+  AllocationStats m_start{};
+  std::uint64_t m_live{ 0 };
+
+public:
+  AllocationScope()
+  {
+    AllocationCounter::resetPeak();
+    m_live = AllocationCounter::liveBytes();
+    m_start = AllocationCounter::total();
+  }
+
+  AllocationStats stats() const
+  {
+    const AllocationStats now{ AllocationCounter::total() };
+    return AllocationStats{ now.allocations - m_start.allocations,
+			    now.deallocations - m_start.deallocations,
+			    now.bytes - m_start.bytes,
+			    (now.peakBytes > m_live) ? now.peakBytes - m_live : 0 };
+  }
+};
+
+#endif
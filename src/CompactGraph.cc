@@ -0,0 +1,88 @@
+
+#include "CompactGraph.h"
+#include "Scalar.h"
+#include "operation_constants.h"
+#include "Exceptions.h"
+
+#include <limits>
+#include <utility>
+
+template <typename T>
+CompactGraph<T>::CompactGraph(const ExecutionPlan<T>& plan)
+{
+  if (plan.size() >= CompactNode::none)
+    throw InvalidOperationException("Graph is too large for 32-bit node indices.");
+  const auto& vars{ plan.getNodes() };
+  m_nodes.reserve(plan.size());
+  m_values.reserve(plan.size());
+  for (std::size_t i{0}; i < plan.size(); ++i)
+    {
+      const auto inputs{ plan.getInputs(i) };
+      if (inputs.size() > 2)
+	throw InvalidOperationException("Compact nodes have at most two inputs.");
+      CompactNode node{};
+      for (std::size_t k{0}; k < inputs.size(); ++k)
+	node.inputs[k] = static_cast<std::uint32_t>(inputs[k]);
+      node.name = vars[i]->getSymbol();
+      node.opcode = vars[i]->getOperation().getOpCode();
+      m_nodes.push_back(node);
+      m_values.push_back(BasicScalar<T>::value(*vars[i]));
+    }
+  for (const std::size_t output : plan.getOutputs())
+    m_outputs.push_back(static_cast<std::uint32_t>(output));
+  for (const std::size_t input : plan.getBoundInputs())
+    {
+      if (input == ExecutionPlan<T>::npos)
+	{
+	  m_boundInputs.push_back(CompactNode::none);
+	  continue;
+	}
+      m_boundInputs.push_back(static_cast<std::uint32_t>(input));
+      m_nodes[input].flags |= CompactNode::boundFlag;
+    }
+}
+
+template <typename T>
+CompactGraph<T>::CompactGraph(std::vector<CompactNode> nodes, std::vector<T> values,
+			      std::vector<std::uint32_t> outputs,
+			      std::vector<std::uint32_t> boundInputs)
+  : m_nodes{ std::move(nodes) }
+  , m_values{ std::move(values) }
+  , m_outputs{ std::move(outputs) }
+  , m_boundInputs{ std::move(boundInputs) }
+{
+  if (m_values.size() != m_nodes.size())
+    throw InvalidOperationException("CompactGraph needs one value per node.");
+}
+
+template <typename T>
+void CompactGraph<T>::forward(std::span<const T> inputs)
+{
+  if (inputs.size() != m_boundInputs.size())
+    throw InvalidOperationException("CompactGraph::forward needs one value per input.");
+  for (std::size_t k{0}; k < inputs.size(); ++k)
+    if (m_boundInputs[k] != CompactNode::none)
+      m_values[m_boundInputs[k]] = inputs[k];
+  for (std::size_t i{0}; i < m_nodes.size(); ++i)
+    {
+      const CompactNode& node{ m_nodes[i] };
+      const std::size_t arity{ node.arity() };
+      if (arity == 0)
+	continue;
+      const T args[2]{ m_values[node.inputs[0]],
+		       (arity == 2) ? m_values[node.inputs[1]] : T{0} };
+      m_values[i] = operationOf<T>(node.opcode).eval({ args, arity });
+    }
+}
+
+template <typename T>
+MemoryUsage CompactGraph<T>::memoryUsage() const
+{
+  return MemoryUsage{ m_nodes.size(),
+		      m_nodes.capacity() * sizeof(CompactNode) + m_values.capacity() * sizeof(T)
+		      + (m_outputs.capacity() + m_boundInputs.capacity()) * sizeof(std::uint32_t) };
+}
+
+template class CompactGraph<float>;
+template class CompactGraph<double>;
+template class CompactGraph<long double>;
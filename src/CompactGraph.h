@@ -0,0 +1,96 @@
+
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+#include "ExecutionPlan.h"
+#include "MemoryUsage.h"
+#include "SymbolTable.h"
+#include "Operation.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+/**
+ * @brief A scalar variable in 16 bytes: the op code, flags, the indices of up to two inputs
+ *        and the interned name. Its value lives in the slot with the same index.
+ */
+struct CompactNode
+{
+  static constexpr std::uint32_t none{ 0xffffffff };
+  static constexpr std::uint8_t boundFlag{ 1 };   // The leaf is a bound input.
+
+  std::uint32_t inputs[2]{ none, none };
+  SymbolTable::Symbol name{ 0 };   // 0 for unnamed variables.
+  OpCode opcode{ OpCode::Input };
+  std::uint8_t flags{ 0 };
+
+  std::size_t arity() const
+  { return (inputs[0] == none) ? 0 : (inputs[1] == none) ? 1 : 2; }
+
+  /** @brief Whether the value is fixed, i.e. a leaf which is not a bound input. */
+  bool isConstant() const
+  { return inputs[0] == none && (flags & boundFlag) == 0; }
+};
+
+static_assert(sizeof(CompactNode) == 16, "A compact node should stay 16 bytes.");
+
+/**
+ * A computational graph stored as a flat array of CompactNode in topological order and one
+ * value slot per node, i.e. 24 bytes per node in double precision against the several
+ * allocations of a Variable and a DirectedGraph node. Consumers are not stored.
+ * @brief Compact copy of a compiled graph.
+ * @note Only the forward pass runs on this format, see InferenceModel and MappedGraph. A Unit
+ *       that is trained keeps its variables, around 240 bytes per node, and compact() needs
+ *       both copies while it runs. Training at the compact footprint would need a backward
+ *       pass over the node array, i.e. the span bprop in reverse order into one adjoint per
+ *       slot, and a Unit built directly on a CompactGraph.
+ */
+template <typename T>
+class CompactGraph
+{
+private:
+  std::vector<CompactNode> m_nodes{};
+  std::vector<T> m_values{};
+  std::vector<std::uint32_t> m_outputs{};
+  std::vector<std::uint32_t> m_boundInputs{};   // CompactNode::none if unused.
+
+public:
+  /**
+   * @brief Copies the structure and the current values of a plan.
+   */
+  explicit CompactGraph(const ExecutionPlan<T>& plan);
+
+  /**
+   * @brief Takes over arrays in the compact format, i.e. read from a file.
+   */
+  CompactGraph(std::vector<CompactNode> nodes, std::vector<T> values,
+	       std::vector<std::uint32_t> outputs, std::vector<std::uint32_t> boundInputs);
+
+  std::size_t size() const
+  { return m_nodes.size(); }
+
+  const std::vector<CompactNode>& getNodes() const
+  { return m_nodes; }
+
+  std::span<const T> getValues() const
+  { return m_values; }
+
+  const std::vector<std::uint32_t>& getOutputs() const
+  { return m_outputs; }
+
+  const std::vector<std::uint32_t>& getBoundInputs() const
+  { return m_boundInputs; }
+
+  /**
+   * @brief Binds one value per bound input and evaluates every node.
+   */
+  void forward(std::span<const T> inputs);
+
+  /** @brief The value of output k from the last forward call. */
+  T getOutput(std::size_t k=0) const
+  { return m_values[m_outputs[k]]; }
+
+  MemoryUsage memoryUsage() const;
+};
+
+#endif
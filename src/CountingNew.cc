@@ -0,0 +1,86 @@
+// Replaces the global operator new and delete with versions that report to
+// AllocationCounter. Linked only into executables that ask for it, see lib_CountingNew.
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  // Every block starts with a header holding the requested size, so that the unsized
+  // deletes know what they free. The header keeps the alignment of the block.
+  constexpr std::size_t headerSize(std::size_t alignment)
+  { return (alignment > alignof(std::max_align_t)) ? alignment : alignof(std::max_align_t); }
+
+  void* allocate(std::size_t size, std::size_t alignment) noexcept
+  {
+    const std::size_t header{ headerSize(alignment) };
+    std::size_t total{ header + size };
+    void* block{};
+    if (alignment > alignof(std::max_align_t)) {
+      total = (total + alignment - 1) / alignment * alignment;   // aligned_alloc needs this.
+      block = std::aligned_alloc(alignment, total);
+    } else {
+      block = std::malloc(total);
+    }
+    if (block == nullptr)
+      return nullptr;
+    char* memory{ static_cast<char*>(block) + header };
+    reinterpret_cast<std::size_t*>(memory)[-1] = size;
+    AllocationCounter::allocated(size);
+    return memory;
+  }
+
+  void deallocate(void* memory, std::size_t alignment) noexcept
+  {
+    if (memory == nullptr)
+      return;
+    AllocationCounter::deallocated(static_cast<std::size_t*>(memory)[-1]);
+    std::free(static_cast<char*>(memory) - headerSize(alignment));
+  }
+
+  void* allocateOrThrow(std::size_t size, std::size_t alignment)
+  {
+    while (true) {
+      if (void* memory{ allocate(size, alignment) })
+	return memory;
+      std::new_handler handler{ std::get_new_handler() };
+      if (handler == nullptr)
+	throw std::bad_alloc{};
+      handler();
+    }
+  }
+
+  const bool s_installed{ (AllocationCounter::install(), true) };
+}
+
+void* operator new(std::size_t size)
+{ return allocateOrThrow(size, alignof(std::max_align_t)); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{ return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{ return allocate(size, alignof(std::max_align_t)); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{ return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory) noexcept
+{ deallocate(memory, alignof(std::max_align_t)); }
+
+void operator delete(void* memory, std::size_t) noexcept
+{ deallocate(memory, alignof(std::max_align_t)); }
+
+void operator delete(void* memory, std::align_val_t alignment) noexcept
+{ deallocate(memory, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept
+{ deallocate(memory, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{ deallocate(memory, alignof(std::max_align_t)); }
+
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{ deallocate(memory, static_cast<std::size_t>(alignment)); }
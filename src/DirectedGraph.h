@@ -8,6 +8,8 @@
 #include <functional>
 #include <algorithm>
 #include <utility>
+#include <unordered_set>
+#include <unordered_map>
 
 /**
  * A directed edge struct used to connect a tail ---> head in a graph.
@@ -70,7 +72,7 @@ public:
   /**
    * @brief Default constructor.
    */
-  DirectedGraph<T>() = default;
+  DirectedGraph() = default;
   /**
    * @brief Add a new node to the graph.
    * @param element The element representing the node.
@@ -153,13 +155,43 @@ public:
    */
   void mergeElements(const T& keptElement, const T& mergedElement);
   /**
-   * @brief Merges two graphs with some common nodes specified as pairs.
+   * @brief Merges two graphs with some common nodes specified as pairs. The other graph is
+   *        left empty. Runs in one pass over the other graph, whose nodes are spliced in.
    * @param o_graph Other graph.
-   * @param pairs Vector of pairs with associated nodes.
+   * @param pairs Vector of pairs with associated nodes, i.e. {kept, merged}.
    */
   void absorbDisjoint(DirectedGraph<T>& o_graph, const std::vector<std::pair<T, T>>& associations);
   void absorb(DirectedGraph<T>& o_graph);
+  /**
+   * @brief A copy of the graph with every element replaced, i.e. a graph of pointers onto
+   *        copies of the pointees. Every node and edge is visited once.
+   * @param mapping Gives the new element for every element of the graph.
+   */
+  template <typename F>
+  DirectedGraph<T> remapped(F mapping) const;
   bool isEmpty() { return (m_graphMap.size() == 0); }
+  std::size_t size() const { return m_graphMap.size(); }
+  /**
+   * @brief Estimated bytes held by the graph, i.e. the tree nodes of the map and the
+   *        neighbour lists. Allocator overhead is not included.
+   */
+  std::size_t memoryUsage() const
+  {
+    // A red-black tree node holds a colour and three pointers besides the key and value.
+    std::size_t bytes{ m_graphMap.size() * (sizeof(std::pair<const T, Node>) + 4 * sizeof(void*)) };
+    for (const auto& [element, node] : m_graphMap)
+      bytes += (node.inputs.capacity() + node.consumers.capacity()) * sizeof(T);
+    return bytes;
+  }
+  /**
+   * Walks the inputs of the sinks depth first without recursion, so that arbitrarily deep
+   * graphs can be ordered.
+   * @brief Gets the sinks and all their ancestors in topological order.
+   * @param sinks Elements whose ancestors are wanted.
+   * @return Every ancestor appears after all of its inputs and exactly once.
+   * @note The graph must be acyclical and T hashable.
+   */
+  std::vector<T> topologicalOrder(const std::vector<T>& sinks) const;
 };
 
 template <typename T>
@@ -346,13 +378,95 @@ template <typename T>
 void DirectedGraph<T>::absorbDisjoint(DirectedGraph<T>& o_graph,
 			      const std::vector<std::pair<T, T>>& associations)
 {
-  m_graphMap.merge(o_graph.m_graphMap);
-  assert(o_graph.m_graphMap.size() == 0 &&
-	 "Do not support merging of graphs with equal elements using associations.");
-  for (const auto& [firstElement, secondElement] : associations)
+  // Instead of merging the elements one by one, which rescans the neighbours of every
+  // merged element, each node of the other graph is visited once and its neighbours are
+  // rewritten through a table of merged -> kept elements.
+  std::unordered_map<T, T> keptOf{};
+  keptOf.reserve(associations.size());
+  for (const auto& [keptElement, mergedElement] : associations)
+    keptOf.emplace(mergedElement, keptElement);
+  auto remap{ [&keptOf](std::vector<T>& elements) {
+    for (T& element : elements)
+      {
+	const auto it{ keptOf.find(element) };
+	if (it != keptOf.end())
+	  element = it->second;
+      }
+  }};
+  // The nodes are moved over without copying their neighbour lists.
+  std::vector<typename std::map<T, Node>::node_type> mergedNodes{};
+  while (!o_graph.m_graphMap.empty())
+    {
+      auto handle{ o_graph.m_graphMap.extract(o_graph.m_graphMap.begin()) };
+      remap(handle.mapped().inputs);
+      remap(handle.mapped().consumers);
+      if (keptOf.count(handle.key()) == 1)
+	{
+	  mergedNodes.push_back(std::move(handle));
+	  continue;
+	}
+      [[maybe_unused]] const auto result{ m_graphMap.insert(std::move(handle)) };
+      assert(result.inserted &&
+	     "Do not support merging of graphs with equal elements using associations.");
+    }
+  // The kept element takes over the edges of the merged element, in order.
+  for (auto& handle : mergedNodes)
+    {
+      Node& kept{ m_graphMap.at(keptOf.at(handle.key())) };
+      const Node& merged{ handle.mapped() };
+      kept.inputs.insert(kept.inputs.end(), merged.inputs.begin(), merged.inputs.end());
+      kept.consumers.insert(kept.consumers.end(), merged.consumers.begin(), merged.consumers.end());
+    }
+}
+
+template <typename T>
+template <typename F>
+DirectedGraph<T> DirectedGraph<T>::remapped(F mapping) const
+{
+  DirectedGraph<T> copy{};
+  auto remapAll{ [&mapping](const std::vector<T>& elements) {
+    std::vector<T> result{};
+    result.reserve(elements.size());
+    for (const T& element : elements)
+      result.push_back(mapping(element));
+    return result;
+  }};
+  for (const auto& [element, node] : m_graphMap)
+    copy.m_graphMap.emplace(mapping(element), Node{ remapAll(node.inputs), remapAll(node.consumers) });
+  return copy;
+}
+
+template <typename T>
+std::vector<T> DirectedGraph<T>::topologicalOrder(const std::vector<T>& sinks) const
+{
+  std::vector<T> order{};
+  std::unordered_set<T> entered{};
+  // Each stack entry is a node and the index of the next input of it to enter.
+  std::vector<std::pair<T, std::size_t>> stack{};
+  for (const T& sink : sinks)
     {
-      mergeElements(firstElement, secondElement);
+      if (!entered.insert(sink).second)
+	continue;
+      stack.emplace_back(sink, 0);
+      while (!stack.empty())
+	{
+	  const T node{ stack.back().first };
+	  const std::vector<T>& inputs{ m_graphMap.at(node).inputs };
+	  if (stack.back().second < inputs.size())
+	    {
+	      const T& input{ inputs[stack.back().second++] };
+	      if (entered.insert(input).second)
+		stack.emplace_back(input, 0);
+	    }
+	  else
+	    {
+	      // All inputs are ordered, so the node can be placed.
+	      order.push_back(node);
+	      stack.pop_back();
+	    }
+	}
     }
+  return order;
 }
 
 template <typename T>
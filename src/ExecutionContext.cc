@@ -0,0 +1,101 @@
+
+#include "ExecutionContext.h"
+#include "Scalar.h"
+#include "Exceptions.h"
+#include "Profiler.h"
+
+#include <array>
+
+template <typename T>
+ExecutionContext<T>::ExecutionContext(std::shared_ptr<const ExecutionPlan<T>> plan)
+  : m_plan{ std::move(plan) }
+  , m_values(m_plan->size(), T{0})
+  , m_adjoints(m_plan->size(), T{0})
+{
+  refresh();
+}
+
+template <typename T>
+void ExecutionContext<T>::refresh()
+{
+  const auto& nodes{ m_plan->getNodes() };
+  for (std::size_t i{0}; i < nodes.size(); ++i)
+    if (m_plan->isLeaf(i))
+      m_values[i] = BasicScalar<T>::value(*nodes[i]);
+}
+
+template <typename T>
+void ExecutionContext<T>::forward(std::span<const T> inputs)
+{
+  const auto& bound{ m_plan->getBoundInputs() };
+  if (inputs.size() != bound.size())
+    throw InvalidOperationException("ExecutionContext::forward needs one value per input.");
+  for (std::size_t k{0}; k < bound.size(); ++k)
+    if (bound[k] != ExecutionPlan<T>::npos)
+      m_values[bound[k]] = inputs[k];
+
+  const auto& nodes{ m_plan->getNodes() };
+  std::array<T, 2> args{};
+  for (std::size_t i{0}; i < nodes.size(); ++i)
+    {
+      const auto inputIdx{ m_plan->getInputs(i) };
+      if (inputIdx.empty())
+	continue;
+      const auto& operation{ nodes[i]->getOperation() };
+      ProfileScope scope{ ProfilePhase::Forward, operation, nodes[i],
+			  (inputIdx.size() + 1) * sizeof(T) };
+      for (std::size_t k{0}; k < inputIdx.size(); ++k)
+	args[k] = m_values[inputIdx[k]];
+      m_values[i] = operation.eval({ args.data(), inputIdx.size() });
+    }
+}
+
+template <typename T>
+void ExecutionContext<T>::backward(std::span<const T> cotangents)
+{
+  const auto& outputs{ m_plan->getOutputs() };
+  if (cotangents.size() != outputs.size())
+    throw InvalidOperationException("ExecutionContext::backward needs one cotangent per output.");
+  std::fill(m_adjoints.begin(), m_adjoints.end(), T{0});
+  for (std::size_t k{0}; k < outputs.size(); ++k)
+    m_adjoints[outputs[k]] += cotangents[k];
+
+  const auto& nodes{ m_plan->getNodes() };
+  std::array<T, 2> args{};
+  for (std::size_t i{nodes.size()}; i-- > 0;)
+    {
+      const auto inputIdx{ m_plan->getInputs(i) };
+      if (inputIdx.empty() || m_adjoints[i] == T{0})
+	continue;
+      for (std::size_t k{0}; k < inputIdx.size(); ++k)
+	args[k] = m_values[inputIdx[k]];
+      const std::span<const T> operands{ args.data(), inputIdx.size() };
+      const auto& operation{ nodes[i]->getOperation() };
+      ProfileScope scope{ ProfilePhase::Backward, operation, nodes[i],
+			  (2 * inputIdx.size() + 1) * sizeof(T) };
+      std::array<T, 2> contributions{};
+      operation.bprop(operands, m_values[i], m_adjoints[i],
+		      { contributions.data(), inputIdx.size() });
+      for (std::size_t k{0}; k < inputIdx.size(); ++k)
+	m_adjoints[inputIdx[k]] += contributions[k];
+    }
+}
+
+template <typename T>
+std::vector<T> ExecutionContext<T>::gradient(std::span<const T> inputs)
+{
+  forward(inputs);
+  std::vector<T> cotangents(m_plan->getOutputs().size(), T{0});
+  cotangents.front() = T{1};
+  backward(cotangents);
+  const auto& bound{ m_plan->getBoundInputs() };
+  std::vector<T> grad(bound.size(), T{0});
+  for (std::size_t k{0}; k < bound.size(); ++k)
+    if (bound[k] != ExecutionPlan<T>::npos)
+      grad[k] = m_adjoints[bound[k]];
+  return grad;
+}
+
+template class ExecutionContext<float>;
+template class ExecutionContext<double>;
+template class ExecutionContext<long double>;
@@ -0,0 +1,68 @@
+
+#ifndef EXECUTION_CONTEXT_H
+#define EXECUTION_CONTEXT_H
+
+#include "ExecutionPlan.h"
+#include <vector>
+#include <memory>
+#include <span>
+
+/**
+ * The values and adjoints of one evaluation of a compiled graph. The plan and its variables
+ * are only read, so any number of contexts may evaluate the same plan from different threads
+ * at once without locks. Every thread should own its context.
+ * @brief Per-thread buffers for evaluating a shared ExecutionPlan.
+ */
+template <typename T>
+class ExecutionContext
+{
+private:
+  std::shared_ptr<const ExecutionPlan<T>> m_plan{};
+  std::vector<T> m_values{};      // Indexed like the nodes of the plan.
+  std::vector<T> m_adjoints{};
+
+public:
+  /**
+   * @brief Creates the buffers and copies the current values of the leafs.
+   */
+  explicit ExecutionContext(std::shared_ptr<const ExecutionPlan<T>> plan);
+
+  /**
+   * @brief Copies the current values of the leafs again, i.e. after a training step changed
+   *        the parameters. Must not run while another thread writes to the variables.
+   */
+  void refresh();
+
+  /**
+   * @brief Binds the values to the inputs of the plan and evaluates every node.
+   * @param inputs One value per bound input of the plan.
+   */
+  void forward(std::span<const T> inputs);
+
+  /**
+   * @brief Reverse sweep over the values of the last forward call.
+   * @param cotangents One value per output of the plan.
+   */
+  void backward(std::span<const T> cotangents);
+
+  /**
+   * @brief The gradient of the first output w.r.t. every bound input.
+   * @return The partial derivatives in the order of the inputs of the plan.
+   */
+  std::vector<T> gradient(std::span<const T> inputs);
+
+  /** @brief The value of output k from the last forward call. */
+  T getOutput(std::size_t k=0) const
+  { return m_values[m_plan->getOutputs()[k]]; }
+
+  std::span<const T> getValues() const
+  { return m_values; }
+
+  std::span<const T> getAdjoints() const
+  { return m_adjoints; }
+
+  const ExecutionPlan<T>& getPlan() const
+  { return *m_plan; }
+};
+
+#endif
@@ -0,0 +1,72 @@
+
+#include "ExecutionPlan.h"
+#include "checks.h"
+#include "Exceptions.h"
+
+#include <unordered_map>
+
+template <typename T>
+ExecutionPlan<T>::ExecutionPlan(const DirectedGraph<vptr>& graph, const std::vector<vptr>& outputs,
+				const std::vector<vptr>& inputs)
+  : m_nodes{ graph.topologicalOrder(outputs) }
+{
+  const std::size_t n{ m_nodes.size() };
+  std::unordered_map<vptr, std::size_t> index{};
+  index.reserve(n);
+  for (std::size_t i{0}; i < n; ++i)
+    index.emplace(m_nodes[i], i);
+
+  // Inputs come before their consumers, so every input index is known here. The graph is
+  // validated once, here, so that the engines running the plan do not check anything.
+  m_inputOffsets.reserve(n + 1);
+  m_forward.dependencies.assign(n, 0);
+  std::vector<std::size_t> consumerCount(n, 0);
+  for (std::size_t i{0}; i < n; ++i)
+    {
+      const auto& nodeInputs{ graph.getNodeInputs(m_nodes[i]) };
+      validateNode(*m_nodes[i], nodeInputs.size());
+      for (const vptr input : nodeInputs)
+	{
+	  const std::size_t j{ index.at(input) };
+	  if (j >= i)   // A topological order only has this for an input on a cycle.
+	    throw InvalidOperationException("Cannot compile a graph with a cycle.");
+	  m_inputs.push_back(j);
+	  ++consumerCount[j];
+	  ++m_forward.dependencies[i];
+	}
+      m_inputOffsets.push_back(m_inputs.size());
+    }
+
+  // Consumer lists are the transposed input lists. Repeated inputs, i.e. x*x, give one
+  // consumer edge each so that they match the dependency counts.
+  m_forward.successorOffsets.assign(n + 1, 0);
+  for (std::size_t i{0}; i < n; ++i)
+    m_forward.successorOffsets[i + 1] = m_forward.successorOffsets[i] + consumerCount[i];
+  m_forward.successors.resize(m_inputs.size());
+  m_inputSlots.reserve(m_inputs.size());
+  std::vector<std::size_t> fill(m_forward.successorOffsets.begin(), m_forward.successorOffsets.end() - 1);
+  for (std::size_t i{0}; i < n; ++i)
+    for (const std::size_t j : getInputs(i))
+      {
+	m_inputSlots.push_back(fill[j]);
+	m_forward.successors[fill[j]++] = i;
+      }
+
+  m_backward.successorOffsets = m_inputOffsets;
+  m_backward.successors = m_inputs;
+  m_backward.dependencies.assign(consumerCount.begin(), consumerCount.end());
+
+  m_outputs.reserve(outputs.size());
+  for (const vptr output : outputs)
+    m_outputs.push_back(index.at(output));
+  m_boundInputs.reserve(inputs.size());
+  for (const vptr input : inputs)
+    {
+      const auto it{ index.find(input) };
+      m_boundInputs.push_back(it == index.end() ? npos : it->second);
+    }
+}
+
+template class ExecutionPlan<float>;
+template class ExecutionPlan<double>;
+template class ExecutionPlan<long double>;
@@ -0,0 +1,103 @@
+
+#ifndef EXECUTION_PLAN_H
+#define EXECUTION_PLAN_H
+
+#include "Variable.h"
+#include "DirectedGraph.h"
+#include "Scheduler.h"
+#include <vector>
+#include <span>
+#include <cstddef>
+
+/**
+ * A computational graph compiled for a fixed set of outputs. The variables the outputs depend
+ * on are numbered in topological order and the edges between them are stored as index arrays,
+ * so that engines can walk the graph without looking anything up in the DirectedGraph.
+ * The plan must be rebuilt when the graph changes.
+ * @brief Compiled, topologically sorted view of a computational graph.
+ */
+template <typename T>
+class ExecutionPlan
+{
+  using vptr = BasicVariable<T>*;
+private:
+  std::vector<vptr> m_nodes{};
+  // The inputs of node i are m_inputs[m_inputOffsets[i]] to m_inputs[m_inputOffsets[i+1]].
+  std::vector<std::size_t> m_inputOffsets{ 0 };
+  std::vector<std::size_t> m_inputs{};
+  // For every input edge, its position in the consumer list of the input.
+  std::vector<std::size_t> m_inputSlots{};
+  std::vector<std::size_t> m_outputs{};
+  std::vector<std::size_t> m_boundInputs{};
+  // Consumer edges inside the plan. Consumers outside of the cone of the outputs are left out.
+  DependencyGraph m_forward{};
+  // The transposed graph, node i is complete once all of its consumers have been walked.
+  DependencyGraph m_backward{};
+
+public:
+  /** @brief Index of an input that the outputs do not depend on. */
+  static constexpr std::size_t npos{ static_cast<std::size_t>(-1) };
+
+  /**
+   * @param graph A computational graph.
+   * @param outputs The variables the plan evaluates.
+   * @param inputs The leafs that are bound to new values on every evaluation, see
+   *               ExecutionContext. The other leafs keep the value they had when the
+   *               context was created.
+   * @throws InvalidOperationException If the graph has a cycle or a variable that is not a
+   *         scalar with as many inputs as its operation takes, see validateNode. Engines
+   *         running the plan rely on this and do not check the graph again.
+   */
+  ExecutionPlan(const DirectedGraph<vptr>& graph, const std::vector<vptr>& outputs,
+		const std::vector<vptr>& inputs={});
+
+  /** @brief Number of variables in the plan, leafs included. */
+  std::size_t size() const
+  { return m_nodes.size(); }
+
+  /** @brief The variables in topological order. */
+  const std::vector<vptr>& getNodes() const
+  { return m_nodes; }
+
+  /** @brief Indices of the inputs of node i, in operand order. Empty for leafs. */
+  std::span<const std::size_t> getInputs(std::size_t i) const
+  { return { m_inputs.data() + m_inputOffsets[i], m_inputOffsets[i + 1] - m_inputOffsets[i] }; }
+
+  /**
+   * @brief For every input of node i, the position of node i among the consumers of that
+   *        input, see getForwardDependencies. Gives every edge of the graph its own slot.
+   */
+  std::span<const std::size_t> getInputSlots(std::size_t i) const
+  { return { m_inputSlots.data() + m_inputOffsets[i], m_inputOffsets[i + 1] - m_inputOffsets[i] }; }
+
+  /** @brief Indices of the outputs, in the order they were given. */
+  const std::vector<std::size_t>& getOutputs() const
+  { return m_outputs; }
+
+  /** @brief Indices of the bound inputs in the order they were given, or npos. */
+  const std::vector<std::size_t>& getBoundInputs() const
+  { return m_boundInputs; }
+
+  /** @brief Whether node i is a leaf, i.e. an input or a parameter. */
+  bool isLeaf(std::size_t i) const
+  { return m_inputOffsets[i] == m_inputOffsets[i + 1]; }
+
+  /**
+   * @brief Node i may be evaluated once all of its dependencies have been, i.e. its inputs.
+   */
+  const DependencyGraph& getForwardDependencies() const
+  { return m_forward; }
+
+  /**
+   * @brief Node i may be walked backwards once all of its dependencies have been, i.e. its
+   *        consumers in the plan.
+   */
+  const DependencyGraph& getBackwardDependencies() const
+  { return m_backward; }
+
+  /** @brief Number of consumer edges in the plan, the same as the number of input edges. */
+  std::size_t edges() const
+  { return m_inputs.size(); }
+};
+
+#endif
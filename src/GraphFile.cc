@@ -0,0 +1,242 @@
+
+#include "GraphFile.h"
+#include "operation_constants.h"
+#include "Exceptions.h"
+
+#include <fstream>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GRAPH_FILE_MMAP 1
+#else
+#define GRAPH_FILE_MMAP 0
+#endif
+
+namespace
+{
+  constexpr std::uint64_t alignment{ 64 };
+
+  std::uint64_t alignUp(std::uint64_t offset)
+  { return (offset + alignment - 1) / alignment * alignment; }
+
+  template <typename U>
+  void writeAt(std::ofstream& out, std::uint64_t offset, const U* data, std::size_t count)
+  {
+    out.seekp(static_cast<std::streamoff>(offset));
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(U)));
+  }
+}
+
+template <typename T>
+void saveGraph(const CompactGraph<T>& graph, const std::string& path)
+{
+  // Symbols only mean something inside one process, so names are written as a table.
+  std::vector<CompactNode> nodes{ graph.getNodes() };
+  std::unordered_map<SymbolTable::Symbol, std::uint32_t> nameIndex{ { 0, 0 } };
+  std::vector<std::uint64_t> nameOffsets{ 0, 0 };   // The empty name.
+  std::string nameChars{};
+  for (CompactNode& node : nodes)
+    {
+      if (SymbolTable::isAnonymous(node.name))
+	node.name = 0;   // Only unique within the process, written as unnamed.
+      const auto [it, added]{ nameIndex.try_emplace(node.name,
+						    static_cast<std::uint32_t>(nameIndex.size())) };
+      if (added)
+	{
+	  nameChars += SymbolTable::name(node.name);
+	  nameOffsets.push_back(nameChars.size());
+	}
+      node.name = it->second;
+    }
+
+  GraphFileHeader header{};
+  std::memcpy(header.magic, GraphFileHeader::magicBytes, sizeof(header.magic));
+  header.valueSize = sizeof(T);
+  header.nodes = nodes.size();
+  header.outputs = graph.getOutputs().size();
+  header.inputs = graph.getBoundInputs().size();
+  header.names = nameOffsets.size() - 1;
+  header.nameChars = nameChars.size();
+  header.nodesOffset = alignUp(sizeof(GraphFileHeader));
+  header.valuesOffset = alignUp(header.nodesOffset + header.nodes * sizeof(CompactNode));
+  header.outputsOffset = alignUp(header.valuesOffset + header.nodes * sizeof(T));
+  header.inputsOffset = alignUp(header.outputsOffset + header.outputs * sizeof(std::uint32_t));
+  header.nameOffsetsOffset = alignUp(header.inputsOffset + header.inputs * sizeof(std::uint32_t));
+  header.nameCharsOffset = alignUp(header.nameOffsetsOffset + nameOffsets.size() * sizeof(std::uint64_t));
+  header.fileSize = header.nameCharsOffset + header.nameChars;
+
+  std::ofstream out{ path, std::ios::binary | std::ios::trunc };
+  if (!out)
+    throw InvalidOperationException("Cannot open " + path + " for writing.");
+  // Write the padding first so that every section lies inside the file.
+  const std::vector<char> zeros(header.fileSize, 0);
+  out.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+  writeAt(out, 0, &header, 1);
+  writeAt(out, header.nodesOffset, nodes.data(), nodes.size());
+  writeAt(out, header.valuesOffset, graph.getValues().data(), graph.getValues().size());
+  writeAt(out, header.outputsOffset, graph.getOutputs().data(), graph.getOutputs().size());
+  writeAt(out, header.inputsOffset, graph.getBoundInputs().data(), graph.getBoundInputs().size());
+  writeAt(out, header.nameOffsetsOffset, nameOffsets.data(), nameOffsets.size());
+  writeAt(out, header.nameCharsOffset, nameChars.data(), nameChars.size());
+  if (!out)
+    throw InvalidOperationException("Failed writing " + path + '.');
+}
+
+template <typename T>
+MappedGraph<T> MappedGraph<T>::open(const std::string& path)
+{
+#if GRAPH_FILE_MMAP
+  const int fd{ ::open(path.c_str(), O_RDONLY) };
+  if (fd < 0)
+    throw InvalidOperationException("Cannot open " + path + '.');
+  struct stat info{};
+  if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(GraphFileHeader)))
+    {
+      ::close(fd);
+      throw InvalidOperationException(path + " is not a graph file.");
+    }
+  const auto size{ static_cast<std::size_t>(info.st_size) };
+  void* address{ ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) };
+  ::close(fd);   // The mapping stays valid.
+  if (address == MAP_FAILED)
+    throw InvalidOperationException("Cannot map " + path + '.');
+  std::shared_ptr<const std::byte> data{ static_cast<const std::byte*>(address),
+					 [size](const std::byte* p) {
+					   ::munmap(const_cast<std::byte*>(p), size); } };
+  return MappedGraph{ std::move(data), size };
+#else
+  std::ifstream in{ path, std::ios::binary | std::ios::ate };
+  if (!in)
+    throw InvalidOperationException("Cannot open " + path + '.');
+  const auto size{ static_cast<std::size_t>(in.tellg()) };
+  // operator new aligns for every fundamental type, which is enough for all sections.
+  std::shared_ptr<std::byte[]> buffer{ new std::byte[size] };
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(size));
+  return MappedGraph{ std::shared_ptr<const std::byte>{ buffer, buffer.get() }, size };
+#endif
+}
+
+template <typename T>
+MappedGraph<T>::MappedGraph(std::shared_ptr<const std::byte> data, std::size_t size)
+  : m_data{ std::move(data) }
+{
+  if (size < sizeof(GraphFileHeader))
+    throw InvalidOperationException("Graph file is truncated.");
+  m_header = reinterpret_cast<const GraphFileHeader*>(m_data.get());
+  const GraphFileHeader& h{ *m_header };
+  if (std::memcmp(h.magic, GraphFileHeader::magicBytes, sizeof(h.magic)) != 0)
+    throw InvalidOperationException("Not a graph file.");
+  if (h.version != GraphFileHeader::currentVersion)
+    throw InvalidOperationException("Unsupported graph file version.");
+  if (h.byteOrder != GraphFileHeader::byteOrderMark || h.nodeSize != sizeof(CompactNode))
+    throw InvalidOperationException("Graph file was written on an incompatible machine.");
+  if (h.valueSize != sizeof(T))
+    throw InvalidOperationException("Graph file has another precision.");
+  auto inside{ [&](std::uint64_t offset, std::uint64_t count, std::uint64_t element) {
+    return offset % alignment == 0 && offset <= size && count <= (size - offset) / element;
+  }};
+  if (h.fileSize != size
+      || !inside(h.nodesOffset, h.nodes, sizeof(CompactNode))
+      || !inside(h.valuesOffset, h.nodes, sizeof(T))
+      || !inside(h.outputsOffset, h.outputs, sizeof(std::uint32_t))
+      || !inside(h.inputsOffset, h.inputs, sizeof(std::uint32_t))
+      || !inside(h.nameOffsetsOffset, h.names + 1, sizeof(std::uint64_t))
+      || !inside(h.nameCharsOffset, h.nameChars, 1))
+    throw InvalidOperationException("Graph file is truncated or corrupt.");
+
+  const std::byte* base{ m_data.get() };
+  m_nodes = { reinterpret_cast<const CompactNode*>(base + h.nodesOffset), h.nodes };
+  m_values = { reinterpret_cast<const T*>(base + h.valuesOffset), h.nodes };
+  m_outputs = { reinterpret_cast<const std::uint32_t*>(base + h.outputsOffset), h.outputs };
+  m_inputs = { reinterpret_cast<const std::uint32_t*>(base + h.inputsOffset), h.inputs };
+  m_nameOffsets = { reinterpret_cast<const std::uint64_t*>(base + h.nameOffsetsOffset), h.names + 1 };
+  m_nameChars = reinterpret_cast<const char*>(base + h.nameCharsOffset);
+}
+
+template <typename T>
+std::string_view MappedGraph<T>::getName(std::size_t i) const
+{
+  const std::uint32_t name{ m_nodes[i].name };
+  if (name >= m_header->names)
+    throw InvalidOperationException("Graph file has a bad name index.");
+  const std::uint64_t begin{ m_nameOffsets[name] };
+  const std::uint64_t end{ m_nameOffsets[name + 1] };
+  if (begin > end || end > m_header->nameChars)
+    throw InvalidOperationException("Graph file has a bad name table.");
+  return { m_nameChars + begin, end - begin };
+}
+
+template <typename T>
+bool MappedGraph<T>::verify() const
+{
+  for (std::size_t i{0}; i < m_nodes.size(); ++i)
+    {
+      const CompactNode& node{ m_nodes[i] };
+      if (static_cast<std::uint8_t>(node.opcode) > static_cast<std::uint8_t>(OpCode::ScalarAbs))
+	return false;
+      const bool leaf{ node.opcode == OpCode::Input };
+      if (leaf != (node.arity() == 0) || node.name >= m_header->names)
+	return false;
+      if (!leaf && operationOf<T>(node.opcode).isBinary() != (node.arity() == 2))
+	return false;
+      for (std::size_t k{0}; k < node.arity(); ++k)
+	if (node.inputs[k] >= i)
+	  return false;
+      if (node.inputs[1] != CompactNode::none && node.inputs[0] == CompactNode::none)
+	return false;
+    }
+  for (const std::uint32_t output : m_outputs)
+    if (output >= m_nodes.size())
+      return false;
+  for (const std::uint32_t input : m_inputs)
+    if (input != CompactNode::none && (input >= m_nodes.size() || m_nodes[input].arity() != 0))
+      return false;
+  return true;
+}
+
+template <typename T>
+T MappedGraph<T>::forward(std::span<const T> inputs, std::span<T> scratch) const
+{
+  if (inputs.size() != m_inputs.size() || scratch.size() != m_nodes.size())
+    throw InvalidOperationException("MappedGraph::forward needs one value per input and node.");
+  for (std::size_t k{0}; k < inputs.size(); ++k)
+    if (m_inputs[k] != CompactNode::none)
+      scratch[m_inputs[k]] = inputs[k];
+  for (std::size_t i{0}; i < m_nodes.size(); ++i)
+    {
+      const CompactNode& node{ m_nodes[i] };
+      const std::size_t arity{ node.arity() };
+      if (arity == 0)
+	continue;
+      const T args[2]{ value(node.inputs[0], scratch),
+		       (arity == 2) ? value(node.inputs[1], scratch) : T{0} };
+      scratch[i] = operationOf<T>(node.opcode).eval({ args, arity });
+    }
+  return m_outputs.empty() ? T{0} : value(m_outputs.front(), scratch);
+}
+
+template <typename T>
+CompactGraph<T> MappedGraph<T>::toCompact() const
+{
+  std::vector<CompactNode> nodes(m_nodes.begin(), m_nodes.end());
+  for (std::size_t i{0}; i < nodes.size(); ++i)
+    nodes[i].name = SymbolTable::intern(std::string{ getName(i) });
+  return CompactGraph<T>{ std::move(nodes), std::vector<T>(m_values.begin(), m_values.end()),
+			  std::vector<std::uint32_t>(m_outputs.begin(), m_outputs.end()),
+			  std::vector<std::uint32_t>(m_inputs.begin(), m_inputs.end()) };
+}
+
+template void saveGraph(const CompactGraph<float>&, const std::string&);
+template void saveGraph(const CompactGraph<double>&, const std::string&);
+template void saveGraph(const CompactGraph<long double>&, const std::string&);
+
+template class MappedGraph<float>;
+template class MappedGraph<double>;
+template class MappedGraph<long double>;
@@ -0,0 +1,122 @@
+
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include "CompactGraph.h"
+#include <string>
+#include <string_view>
+#include <span>
+#include <memory>
+#include <cstdint>
+
+/**
+ * The file starts with this header followed by sections at 64 byte aligned offsets: the
+ * CompactNode array, one value per node, the output and bound input indices, and the name
+ * table. Node names are indices into the name table, 0 being unnamed. All data is in the
+ * byte order and layout of the writing machine, which the header records, so that a mapped
+ * file is used in place without parsing.
+ * @brief Header of the binary graph format, version 1.
+ */
+struct GraphFileHeader
+{
+  static constexpr char magicBytes[8]{ 'A', 'D', 'G', 'R', 'A', 'P', 'H', '\0' };
+  static constexpr std::uint32_t currentVersion{ 1 };
+  static constexpr std::uint32_t byteOrderMark{ 0x01020304 };
+
+  char magic[8]{};
+  std::uint32_t version{ currentVersion };
+  std::uint32_t byteOrder{ byteOrderMark };
+  std::uint32_t valueSize{ 0 };         // sizeof(T), i.e. 8 for double.
+  std::uint32_t nodeSize{ sizeof(CompactNode) };
+  std::uint64_t nodes{ 0 };
+  std::uint64_t outputs{ 0 };
+  std::uint64_t inputs{ 0 };
+  std::uint64_t names{ 0 };             // Entries in the name table, the empty name included.
+  std::uint64_t nameChars{ 0 };
+  std::uint64_t nodesOffset{ 0 };
+  std::uint64_t valuesOffset{ 0 };
+  std::uint64_t outputsOffset{ 0 };
+  std::uint64_t inputsOffset{ 0 };
+  std::uint64_t nameOffsetsOffset{ 0 }; // names + 1 offsets into the characters.
+  std::uint64_t nameCharsOffset{ 0 };
+  std::uint64_t fileSize{ 0 };
+};
+
+/**
+ * @brief Writes a compact graph and its values in the binary graph format.
+ * @throw InvalidOperationException if the file cannot be written.
+ */
+template <typename T>
+void saveGraph(const CompactGraph<T>& graph, const std::string& path);
+
+/**
+ * A graph file mapped into memory, on POSIX systems with mmap and elsewhere read into one
+ * buffer. Opening only checks the header and that the sections lie inside the file; the
+ * arrays are then used in place, so large graphs open in constant time and the pages of the
+ * parameters are shared between processes mapping the same file.
+ * @brief Read-only view of a graph file.
+ */
+template <typename T>
+class MappedGraph
+{
+private:
+  std::shared_ptr<const std::byte> m_data{};   // Unmaps or frees on destruction.
+  const GraphFileHeader* m_header{ nullptr };
+  std::span<const CompactNode> m_nodes{};
+  std::span<const T> m_values{};
+  std::span<const std::uint32_t> m_outputs{};
+  std::span<const std::uint32_t> m_inputs{};
+  std::span<const std::uint64_t> m_nameOffsets{};
+  const char* m_nameChars{ nullptr };
+
+  MappedGraph(std::shared_ptr<const std::byte> data, std::size_t size);
+
+public:
+  /**
+   * @throw InvalidOperationException if the file is missing, of another version, precision,
+   *        byte order or truncated.
+   */
+  static MappedGraph open(const std::string& path);
+
+  std::size_t size() const
+  { return m_nodes.size(); }
+
+  std::span<const CompactNode> getNodes() const
+  { return m_nodes; }
+
+  /** @brief The values when the graph was saved, i.e. the parameters. */
+  std::span<const T> getValues() const
+  { return m_values; }
+
+  std::span<const std::uint32_t> getOutputs() const
+  { return m_outputs; }
+
+  std::span<const std::uint32_t> getBoundInputs() const
+  { return m_inputs; }
+
+  /** @brief The name of node i, empty for unnamed nodes. */
+  std::string_view getName(std::size_t i) const;
+
+  /**
+   * @brief Checks every node, i.e. that inputs come before their consumers and op codes are
+   *        known. Linear in the size of the graph, which open does not do.
+   */
+  bool verify() const;
+
+  /**
+   * @brief Evaluates the graph. Constants are read from the file in place.
+   * @param inputs One value per bound input.
+   * @param scratch One value per node, receiving the inputs and computed values.
+   * @return The value of the first output.
+   */
+  T forward(std::span<const T> inputs, std::span<T> scratch) const;
+
+  /** @brief The value of node i after a forward call with scratch. */
+  T value(std::size_t i, std::span<const T> scratch) const
+  { return m_nodes[i].isConstant() ? m_values[i] : scratch[i]; }
+
+  /** @brief A copy that can be evaluated, frozen or turned back into a Unit. */
+  CompactGraph<T> toCompact() const;
+};
+
+#endif
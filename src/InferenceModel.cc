@@ -0,0 +1,176 @@
+
+#include "InferenceModel.h"
+#include "operation_constants.h"
+#include "Exceptions.h"
+
+#include <cmath>
+#include <limits>
+
+template <typename T>
+InferenceModel<T>::InferenceModel(const CompactGraph<T>& graph)
+{
+  const auto& nodes{ graph.getNodes() };
+  const auto values{ graph.getValues() };
+  const std::size_t n{ nodes.size() };
+  constexpr std::uint32_t none{ CompactNode::none };
+  constexpr std::size_t never{ std::numeric_limits<std::size_t>::max() };
+
+  // Last instruction reading each node. Outputs are read after the last instruction.
+  std::vector<std::size_t> lastUse(n, 0);
+  for (std::size_t i{0}; i < n; ++i)
+    for (std::size_t k{0}; k < nodes[i].arity(); ++k)
+      lastUse[nodes[i].inputs[k]] = i;
+  for (const std::uint32_t output : graph.getOutputs())
+    lastUse[output] = never;
+
+  // A node is constant when it is a leaf that is not bound or all its inputs are constant.
+  std::vector<bool> bound(n, false);
+  const auto& boundInputs{ graph.getBoundInputs() };
+  for (const std::uint32_t input : boundInputs)
+    if (input != none)
+      bound[input] = true;
+  std::vector<bool> constant(n, false);
+  std::vector<T> folded(values.begin(), values.end());
+  for (std::size_t i{0}; i < n; ++i)
+    {
+      const CompactNode& node{ nodes[i] };
+      const std::size_t arity{ node.arity() };
+      if (arity == 0)
+	{
+	  constant[i] = !bound[i];
+	  continue;
+	}
+      bool allConstant{ true };
+      for (std::size_t k{0}; k < arity; ++k)
+	allConstant = allConstant && constant[node.inputs[k]];
+      if (allConstant)
+	{
+	  const T args[2]{ folded[node.inputs[0]], (arity == 2) ? folded[node.inputs[1]] : T{0} };
+	  folded[i] = operationOf<T>(node.opcode).eval({ args, arity });
+	  constant[i] = true;
+	}
+    }
+
+  // Registers: inputs first, in the order they are bound, then the constants that are read.
+  std::vector<std::uint32_t> reg(n, none);
+  m_inputs = boundInputs.size();
+  for (std::size_t k{0}; k < boundInputs.size(); ++k)
+    if (boundInputs[k] != none)
+      reg[boundInputs[k]] = static_cast<std::uint32_t>(k);
+  m_registers.resize(m_inputs, T{0});
+  std::vector<bool> needed(n, false);   // Constants read by a computed node or an output.
+  for (std::size_t i{0}; i < n; ++i)
+    if (!constant[i])
+      for (std::size_t k{0}; k < nodes[i].arity(); ++k)
+	needed[nodes[i].inputs[k]] = true;
+  for (const std::uint32_t output : graph.getOutputs())
+    needed[output] = true;
+  for (std::size_t i{0}; i < n; ++i)
+    {
+      if (constant[i] && needed[i])
+	{
+	  reg[i] = static_cast<std::uint32_t>(m_registers.size());
+	  m_registers.push_back(folded[i]);
+	}
+    }
+  m_constants = m_registers.size() - m_inputs;
+
+  // Scratch registers are handed out in program order and returned after their last read.
+  std::vector<std::uint32_t> freeRegisters{};
+  for (std::size_t i{0}; i < n; ++i)
+    {
+      const CompactNode& node{ nodes[i] };
+      const std::size_t arity{ node.arity() };
+      if (arity == 0 || constant[i])
+	continue;
+      Instruction instruction{ node.opcode, 0, { 0, 0 } };
+      for (std::size_t k{0}; k < arity; ++k)
+	instruction.src[k] = reg[node.inputs[k]];
+      // Operands read for the last time free their register before dst is chosen, so that
+      // an instruction may overwrite its own operand.
+      for (std::size_t k{0}; k < arity; ++k)
+	{
+	  const std::uint32_t input{ node.inputs[k] };
+	  const bool scratch{ reg[input] >= m_inputs + m_constants };
+	  if (scratch && lastUse[input] == i && (k == 0 || node.inputs[0] != input))
+	    freeRegisters.push_back(reg[input]);
+	}
+      if (freeRegisters.empty())
+	{
+	  reg[i] = static_cast<std::uint32_t>(m_registers.size());
+	  m_registers.push_back(T{0});
+	}
+      else
+	{
+	  reg[i] = freeRegisters.back();
+	  freeRegisters.pop_back();
+	}
+      instruction.dst = reg[i];
+      m_instructions.push_back(instruction);
+    }
+  for (const std::uint32_t output : graph.getOutputs())
+    m_outputs.push_back(reg[output]);
+}
+
+template <typename T>
+InferenceModel<T>::InferenceModel(std::vector<Instruction> instructions,
+				  std::vector<std::uint32_t> outputs, std::vector<T> registers,
+				  std::size_t inputs, std::size_t constants)
+  : m_instructions{ std::move(instructions) }
+  , m_outputs{ std::move(outputs) }
+  , m_registers{ std::move(registers) }
+  , m_inputs{ inputs }
+  , m_constants{ constants }
+{
+  if (m_inputs + m_constants > m_registers.size())
+    throw InvalidOperationException("Too few registers for the inputs and constants.");
+  for (const Instruction& instruction : m_instructions)
+    if (instruction.dst >= m_registers.size() || instruction.src[0] >= m_registers.size()
+	|| instruction.src[1] >= m_registers.size())
+      throw InvalidOperationException("Instruction refers to a register out of range.");
+  for (const std::uint32_t output : m_outputs)
+    if (output >= m_registers.size())
+      throw InvalidOperationException("Output refers to a register out of range.");
+}
+
+template <typename T>
+T InferenceModel<T>::forward(std::span<const T> inputs)
+{
+  if (inputs.size() != m_inputs)
+    throw InvalidOperationException("InferenceModel::forward needs one value per input.");
+  T* r{ m_registers.data() };
+  std::copy(inputs.begin(), inputs.end(), r);
+  for (const Instruction& in : m_instructions)
+    {
+      const T a{ r[in.src[0]] };
+      const T b{ r[in.src[1]] };
+      // The same kernels as the operations, without the virtual calls.
+      switch (in.opcode)
+	{
+	case OpCode::ScalarAdd: r[in.dst] = a + b; break;
+	case OpCode::ScalarSub: r[in.dst] = a - b; break;
+	case OpCode::ScalarMul: r[in.dst] = a * b; break;
+	case OpCode::ScalarDiv: r[in.dst] = a / b; break;
+	case OpCode::ScalarXpn: r[in.dst] = std::pow(a, b); break;
+	case OpCode::ScalarExp: r[in.dst] = std::exp(a); break;
+	case OpCode::ScalarLog: r[in.dst] = std::log(a); break;
+	case OpCode::ScalarAbs: r[in.dst] = std::abs(a); break;
+	case OpCode::Input:
+	  throw InvalidOperationException("Input is not an instruction.");
+	}
+    }
+  return m_outputs.empty() ? T{0} : r[m_outputs.front()];
+}
+
+template <typename T>
+MemoryUsage InferenceModel<T>::memoryUsage() const
+{
+  return MemoryUsage{ m_instructions.size(),
+		      m_instructions.capacity() * sizeof(Instruction)
+		      + m_outputs.capacity() * sizeof(std::uint32_t)
+		      + m_registers.capacity() * sizeof(T) };
+}
+
+template class InferenceModel<float>;
+template class InferenceModel<double>;
+template class InferenceModel<long double>;
@@ -0,0 +1,86 @@
+
+#ifndef INFERENCE_MODEL_H
+#define INFERENCE_MODEL_H
+
+#include "CompactGraph.h"
+#include "MemoryUsage.h"
+#include "Operation.h"
+#include <vector>
+#include <span>
+#include <cstdint>
+
+/**
+ * @brief One step of an InferenceModel: dst = op(src[0], src[1]), all register indices.
+ */
+struct Instruction
+{
+  OpCode opcode{ OpCode::Input };
+  std::uint32_t dst{ 0 };
+  std::uint32_t src[2]{ 0, 0 };
+};
+
+/**
+ * A frozen graph for serving. Only the forward instructions, the constants and one register
+ * file are kept: no variables, names, consumers or gradients. The registers are laid out as
+ * the inputs, then the constants, then scratch registers. Scratch registers are reused once
+ * the value they hold is no longer read, so the register file is usually much smaller than
+ * the graph. Instructions whose operands are all constants are evaluated when freezing.
+ * @brief Immutable forward-only instruction stream.
+ */
+template <typename T>
+class InferenceModel
+{
+private:
+  std::vector<Instruction> m_instructions{};
+  std::vector<std::uint32_t> m_outputs{};   // Registers of the outputs.
+  std::vector<T> m_registers{};             // Constants are written once, at freeze time.
+  std::size_t m_inputs{ 0 };
+  std::size_t m_constants{ 0 };
+
+public:
+  /**
+   * @brief Freezes a compact graph. Leafs that are not bound inputs become constants.
+   */
+  explicit InferenceModel(const CompactGraph<T>& graph);
+
+  /**
+   * @param instructions The forward instructions, in order.
+   * @param registers The register file with the constants in place and any inputs and scratch.
+   */
+  InferenceModel(std::vector<Instruction> instructions, std::vector<std::uint32_t> outputs,
+		 std::vector<T> registers, std::size_t inputs, std::size_t constants);
+
+  /**
+   * @brief Evaluates the model.
+   * @param inputs One value per bound input of the frozen graph.
+   * @return The value of the first output, see getOutput for the others.
+   */
+  T forward(std::span<const T> inputs);
+
+  /** @brief The value of output k from the last forward call. */
+  T getOutput(std::size_t k=0) const
+  { return m_registers[m_outputs[k]]; }
+
+  const std::vector<Instruction>& getInstructions() const
+  { return m_instructions; }
+
+  const std::vector<std::uint32_t>& getOutputs() const
+  { return m_outputs; }
+
+  std::span<const T> getRegisters() const
+  { return m_registers; }
+
+  std::size_t getInputCount() const
+  { return m_inputs; }
+
+  std::size_t getConstantCount() const
+  { return m_constants; }
+
+  /** @brief Number of registers used for intermediate values. */
+  std::size_t getScratchSize() const
+  { return m_registers.size() - m_inputs - m_constants; }
+
+  MemoryUsage memoryUsage() const;
+};
+
+#endif
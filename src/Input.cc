@@ -2,29 +2,63 @@
 #include "Input.h"
 #include "Exceptions.h"
 
-std::unique_ptr<Variable> Input::operator()(const Variable& input) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicInput<T>::operator()(const BasicVariable<T>& input) const
 {
   throw InvalidOperationException("Input does not have operator() capabilities.");
 }
 
-std::unique_ptr<Variable> Input::operator()(DirectedGraph<Variable*>& graph, Variable& input) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicInput<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+							    BasicVariable<T>& input) const
 {
   throw InvalidOperationException("Input does not have operatior() capabilities.");
 }
 
-void Input::uop(const Variable& input, Variable& variable) const
+template <typename T>
+void BasicInput<T>::uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const
 {
   throw InvalidOperationException("Input does not have uop capabilities.");
 }
 
-Gradient Input::bprop(const std::vector<Variable*>& inputs,
-		      const Variable& diff_var, const Gradient& gradient) const
+template <typename T>
+BasicGradient<T> BasicInput<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+				      const BasicVariable<T>& diff_var,
+				      const BasicGradient<T>& gradient) const
 {
-  throw InvalidOperationException("Input does not have bprop capabilities.");  
+  throw InvalidOperationException("Input does not have bprop capabilities.");
 }
 
-std::ostream& Input::print(std::ostream& out) const
+template <typename T>
+OpCode BasicInput<T>::getOpCode() const
+{ return OpCode::Input; }
+
+template <typename T>
+T BasicInput<T>::eval(std::span<const T> args) const
+{
+  throw InvalidOperationException("Input does not have eval capabilities.");
+}
+
+template <typename T>
+T BasicInput<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  throw InvalidOperationException("Input does not have partial capabilities.");
+}
+
+template <typename T>
+void BasicInput<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  throw InvalidOperationException("Input does not have bprop capabilities.");
+}
+
+template <typename T>
+std::ostream& BasicInput<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicInput<float>;
+template class BasicInput<double>;
+template class BasicInput<long double>;
@@ -11,23 +11,35 @@
 
 
 
-class Input : public OperationUnary
+template <typename T>
+class BasicInput : public BasicOperationUnary<T>
 {
 private:
   static constexpr std::string_view m_name{"Input"};
 
 public:
-  virtual std::unique_ptr<Variable> operator()(const Variable& input) const override;
-  
-  virtual std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph, Variable& input) const override;
+  virtual std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& input) const override;
 
-  void uop(const Variable& input, Variable& variable) const override;  
+  virtual std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& input) const override;
+
+  void uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const override;
+
+  BasicGradient<T> bprop(const std::vector<BasicVariable<T>*>& inputs,
+			 const BasicVariable<T>& diff_var,
+			 const BasicGradient<T>& gradient) const override;
+
+  OpCode getOpCode() const override;
+
+  T eval(std::span<const T> args) const override;
+
+  T partial(std::span<const T> args, std::size_t index) const override;
+
+  void bprop(std::span<const T> args, T output, T gradient, std::span<T> adjoints) const override;
 
-  Gradient bprop(const std::vector<Variable*>& inputs,
-		 const Variable& diff_var, const Gradient& gradient) const override;
-  
   std::ostream& print(std::ostream& out) const override;
 };
 
+using Input = BasicInput<double>;
 
 #endif
@@ -0,0 +1,30 @@
+
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <iostream>
+
+/**
+ * @brief Memory held by a graph representation, estimated from the sizes of its objects and
+ *        the capacities of its containers. Allocator overhead is not included.
+ * @param nodes Number of variables.
+ * @param bytes Bytes held for them, the graph structure included.
+ */
+struct MemoryUsage
+{
+  std::size_t nodes{ 0 };
+  std::size_t bytes{ 0 };
+
+  double bytesPerNode() const
+  { return (nodes == 0) ? 0.0 : static_cast<double>(bytes) / static_cast<double>(nodes); }
+
+  friend std::ostream& operator<<(std::ostream& out, const MemoryUsage& usage)
+  {
+    out << usage.nodes << " nodes, " << usage.bytes << " bytes, "
+	<< usage.bytesPerNode() << " bytes/node";
+    return out;
+  }
+};
+
+#endif
@@ -0,0 +1,67 @@
+
+#include "MixedPrecision.h"
+#include "Scalar.h"
+
+#include <cmath>
+#include <algorithm>
+
+MixedPrecisionTrainer::MixedPrecisionTrainer(BasicUnit<float>& unit, double learningRate,
+					     LossScaling scaling)
+  : m_unit{ unit }
+  , m_parameters{ unit.getParameters() }
+  , m_learningRate{ learningRate }
+  , m_scaling{ scaling }
+  , m_lossScale{ scaling.initialScale }
+{
+  m_master.reserve(m_parameters.size());
+  for (auto param : m_parameters)
+    m_master.push_back(static_cast<double>(BasicScalar<float>::value(*param)));
+  m_gradients.assign(m_parameters.size(), 0.0);
+}
+
+bool MixedPrecisionTrainer::step(float inputValue)
+{
+  // Forward and backward in float with the loss multiplied by the scale.
+  auto grad_table{ m_unit.gradients(inputValue, static_cast<float>(m_lossScale)) };
+  m_loss = static_cast<double>(BasicScalar<float>::value(m_unit.getOutput()));
+
+  // Unscale into double. Any inf or nan means the scale was too large for float.
+  std::vector<double> gradients(m_parameters.size(), 0.0);
+  bool finite{ std::isfinite(m_loss) };
+  for (std::size_t i{0}; i < m_parameters.size(); ++i)
+    {
+      const auto it{ grad_table.find(m_parameters[i]) };
+      if (it == grad_table.end())
+	continue;   // Parameter does not influence the output.
+      const double scaled{ static_cast<double>(it->second[0]) };
+      finite = finite && std::isfinite(scaled);
+      gradients[i] = scaled / m_lossScale;
+    }
+  if (!finite)
+    {
+      m_lossScale = std::max(m_lossScale * m_scaling.backoffFactor, m_scaling.minScale);
+      m_goodSteps = 0;
+      ++m_skippedSteps;
+      return false;
+    }
+
+  // The update is accumulated in double so that steps smaller than the float spacing of the
+  // weights are not lost.
+  for (std::size_t i{0}; i < m_parameters.size(); ++i)
+    m_master[i] -= m_learningRate * gradients[i];
+  m_gradients = std::move(gradients);
+  syncParameters();
+
+  if (++m_goodSteps == m_scaling.growthInterval)
+    {
+      m_lossScale *= m_scaling.growthFactor;
+      m_goodSteps = 0;
+    }
+  return true;
+}
+
+void MixedPrecisionTrainer::syncParameters()
+{
+  for (std::size_t i{0}; i < m_parameters.size(); ++i)
+    BasicScalar<float>::setValue(*m_parameters[i], static_cast<float>(m_master[i]));
+}
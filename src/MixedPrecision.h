@@ -0,0 +1,85 @@
+
+#ifndef MIXED_PRECISION_H
+#define MIXED_PRECISION_H
+
+#include "Unit.h"
+#include "Variable.h"
+
+#include <vector>
+
+/**
+ * Trains the parameters of a float unit while keeping a double precision master copy of
+ * every parameter. Forward and backward propagation run in float, the gradients are unscaled
+ * and applied to the master weights in double, and the updated weights are then rounded back
+ * into the unit.
+ *
+ * The output of the unit is treated as the loss. Before the backward pass it is multiplied
+ * by a loss scale so that small gradients do not flush to zero in float. If any gradient
+ * overflows the step is skipped and the scale is reduced, and after a number of successful
+ * steps in a row the scale is increased again.
+ * @brief Mixed precision gradient descent for BasicUnit<float>.
+ */
+class MixedPrecisionTrainer
+{
+public:
+  /**
+   * @brief Parameters of the dynamic loss scaling.
+   * @param initialScale The loss scale used for the first step.
+   * @param growthFactor Factor the scale is multiplied with after growthInterval good steps.
+   * @param backoffFactor Factor the scale is multiplied with after an overflow.
+   * @param growthInterval Number of good steps in a row before the scale is increased.
+   * @param minScale The scale is never reduced below this value.
+   */
+  struct LossScaling
+  {
+    double initialScale{ 65536.0 };
+    double growthFactor{ 2.0 };
+    double backoffFactor{ 0.5 };
+    int growthInterval{ 2000 };
+    double minScale{ 1.0 };
+  };
+
+private:
+  BasicUnit<float>& m_unit;
+  std::vector<BasicVariable<float>*> m_parameters{};
+  std::vector<double> m_master{};
+  std::vector<double> m_gradients{};
+  double m_learningRate{};
+  LossScaling m_scaling{};
+  double m_lossScale{};
+  int m_goodSteps{ 0 };
+  int m_skippedSteps{ 0 };
+  double m_loss{ 0.0 };
+
+public:
+  /**
+   * @param unit The unit to train. Its parameters are copied into the master weights.
+   * @param learningRate Step size of the gradient descent.
+   * @param scaling Dynamic loss scaling parameters.
+   */
+  MixedPrecisionTrainer(BasicUnit<float>& unit, double learningRate, LossScaling scaling);
+  MixedPrecisionTrainer(BasicUnit<float>& unit, double learningRate)
+    : MixedPrecisionTrainer{ unit, learningRate, LossScaling{} }
+  {}
+
+  /**
+   * @brief Performs one training step for the given input.
+   * @return true if the parameters were updated, false if the step was skipped because the
+   *         scaled gradients overflowed.
+   */
+  bool step(float inputValue);
+
+  /** @brief Copies the master weights into the unit parameters, rounding to float. */
+  void syncParameters();
+
+  double getLossScale() const { return m_lossScale; }
+  int getSkippedSteps() const { return m_skippedSteps; }
+  /** @brief The loss, i.e. the unit output, of the last step. */
+  double getLoss() const { return m_loss; }
+  /** @brief The master weights in the order of BasicUnit::getParameters(). */
+  const std::vector<double>& getMasterWeights() const { return m_master; }
+  /** @brief The unscaled gradients of the last step that was not skipped. */
+  const std::vector<double>& getGradients() const { return m_gradients; }
+};
+
+#endif
@@ -1,7 +1,7 @@
 /**
- * @todo      
+ * @todo
  * It would perhaps be appropriate if each variable in the graph has an evaluate function which
- * would use its own operation and inputs to generate a value for itself. We could then walk 
+ * would use its own operation and inputs to generate a value for itself. We could then walk
  * through any graph and evaluate each node separately.
  *
  * The idea here is that the operation is separate from the Variable objects.
@@ -19,15 +19,50 @@
 #include "Exceptions.h"
 #include <iostream>
 #include <vector>
+#include <span>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
 
 // This is a forward declation of Variable since including variable here will cause a circular dependency.
-class Variable;
+template <typename T>
+class BasicVariable;
 
+/**
+ * @brief Identifies an operation in compact and serialized graphs, see operationOf.
+ */
+enum class OpCode : std::uint8_t
+{
+  Input,
+  ScalarAdd,
+  ScalarSub,
+  ScalarMul,
+  ScalarDiv,
+  ScalarXpn,
+  ScalarExp,
+  ScalarLog,
+  ScalarAbs,
+};
+
+/**
+ * @brief The gradient of a variable, stored in the precision of the graph.
+ */
+template <typename T>
+using BasicGradient = std::vector<T>;
 
-using Gradient = std::vector<double>;
+using Gradient = BasicGradient<double>;
 
-class Operation
+/**
+ * Interface for an operation working on variables holding values of type T. The value type
+ * is the numeric precision of the whole computational graph, i.e. float, double or long double.
+ * @brief Operation base class.
+ */
+template <typename T>
+class BasicOperation
 {
+  static_assert(std::is_floating_point_v<T>, "Operations are only defined for floating point types.");
+
 private:
   static constexpr std::string_view m_name{"Operation"};
 
@@ -36,30 +71,61 @@ private:
     out << m_name;
     return out;
   }
-  
+
 public:
-  virtual ~Operation() = default;
-  
-  friend bool operator==(const Operation& op1, const Operation& op2);
+  using value_type = T;
+
+  virtual ~BasicOperation() = default;
 
-  friend std::ostream& operator<<(std::ostream& out, const Operation& op)
+  friend std::ostream& operator<<(std::ostream& out, const BasicOperation& op)
   {
     return op.print(out);
   }
 
   virtual bool isUnary() const = 0;
   virtual bool isBinary() const = 0;
+  virtual OpCode getOpCode() const = 0;
+
+  virtual void bop(const BasicVariable<T>& input1, const BasicVariable<T>& input2,
+		   BasicVariable<T>& variable) const = 0;
+  virtual void uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const = 0;
+  virtual BasicGradient<T> bprop(const std::vector<BasicVariable<T>*>& inputs,
+				 const BasicVariable<T>& diff_var,
+				 const BasicGradient<T>& gradient) const = 0;
 
-  virtual void bop(const Variable& input1, const Variable& input2, Variable& variable) const = 0;
-  virtual void uop(const Variable& input, Variable& variable) const = 0;
-  virtual Gradient bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			 const Gradient& gradient) const = 0;
+  /**
+   * The value kernels work on plain values instead of variables, so that a compiled graph
+   * can be evaluated into buffers owned by the caller, see ExecutionContext.
+   * @brief Computes the value of the operation.
+   * @param args The values of the inputs, in operand order.
+   */
+  virtual T eval(std::span<const T> args) const = 0;
+  /**
+   * @brief The partial derivative of the operation w.r.t. one operand.
+   * @param args The values of the inputs, in operand order.
+   * @param index The operand, i.e. 0 for the dividend and 1 for the divisor of x/y.
+   */
+  virtual T partial(std::span<const T> args, std::size_t index) const = 0;
+  /**
+   * Unlike the bprop on variables nothing is allocated, and work shared by the partials of
+   * several operands, i.e. 1/y of x/y, is done once. Operands are told apart by position,
+   * so repeated operands such as x - x are handled.
+   * @brief Adds the gradient of every operand to its adjoint in a single call.
+   * @param args The values of the inputs, in operand order.
+   * @param output The value of the operation computed by the forward pass. Operations such as
+   *               exp(x) take their derivative from it instead of evaluating themselves again.
+   * @param gradient The gradient of the output of the operation.
+   * @param adjoints One adjoint per operand, the gradient w.r.t. it is added with +=.
+   */
+  virtual void bprop(std::span<const T> args, T output, T gradient, std::span<T> adjoints) const = 0;
 };
 
 // May want to move this to other file, although I think it should be fine here as long as
 // I mark it as inline.
-inline bool operator==(const Operation& op1, const Operation& op2)
+template <typename T>
+inline bool operator==(const BasicOperation<T>& op1, const BasicOperation<T>& op2)
 { return &op1 == &op2; }
 
+using Operation = BasicOperation<double>;
 
 #endif
@@ -1,5 +1,4 @@
 
-
 #ifndef OPERATIONBINARY_H
 #define OPERATIONBINARY_H
 
@@ -16,18 +15,21 @@
  * forward values and backward gradients.
  * @brief Binary operator base class.
  */
-class OperationBinary : public Operation
+template <typename T>
+class BasicOperationBinary : public BasicOperation<T>
 {
 public:
-  virtual ~OperationBinary() override = default;
+  virtual ~BasicOperationBinary() override = default;
+
+  virtual std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& input1,
+						       const BasicVariable<T>& input2) const = 0;
 
-  virtual std::unique_ptr<Variable> operator()(const Variable& input1, const Variable& input2) const = 0;
+  virtual std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& input1,
+						       BasicVariable<T>& input2) const = 0;
 
-  virtual std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph,
-					       Variable& input1, Variable& input2) const = 0;
-  
 
-  virtual void uop(const Variable& input, Variable& variable) const override
+  virtual void uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const override
   {
     throw InvalidOperationException("Unary operation: Variable -> Variable unsupported for binary operation");
   }
@@ -37,4 +39,6 @@ public:
   bool isBinary() const override { return true; }
 };
 
+using OperationBinary = BasicOperationBinary<double>;
+
 #endif
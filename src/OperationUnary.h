@@ -14,24 +14,28 @@
  * forward values and backward gradients.
  * @brief Unary operator base class.
  */
-class OperationUnary : public Operation
-{  
+template <typename T>
+class BasicOperationUnary : public BasicOperation<T>
+{
  public:
-  virtual ~OperationUnary() override = default;
+  virtual ~BasicOperationUnary() override = default;
 
-  virtual std::unique_ptr<Variable> operator()(const Variable& input) const = 0;
+  virtual std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& input) const = 0;
 
-  virtual std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph, Variable& input) const = 0;
-  
-  void bop(const Variable& input1, const Variable& input2, Variable& variable) const override
+  virtual std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& input) const = 0;
+
+  void bop(const BasicVariable<T>& input1, const BasicVariable<T>& input2,
+	   BasicVariable<T>& variable) const override
   {
     throw InvalidOperationException("Binary operation Variable, Variable -> Variable is unsupported for unary operation.");
   }
 
   bool isUnary() const override { return true; }
-  
+
   bool isBinary() const override { return false; }
 };
 
+using OperationUnary = BasicOperationUnary<double>;
 
 #endif
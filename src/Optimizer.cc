@@ -0,0 +1,195 @@
+#include "Optimizer.h"
+#include "Scalar.h"
+#include "ThreadPool.h"
+#include "Exceptions.h"
+
+#include <atomic>
+#include <cmath>
+
+template <typename T>
+BasicOptimizer<T>::BasicOptimizer(BasicUnit<T>& unit, const OptimizerOptions& options)
+  : m_unit{ unit }
+  , m_parameters{ unit.getParameters() }
+  , m_options{ options }
+  , m_learningRate{ static_cast<T>(options.learningRate) }
+  , m_weightDecay{ static_cast<T>(options.weightDecay) }
+  , m_clip{ (options.clipValue > 0) ? static_cast<T>(options.clipValue)
+				    : std::numeric_limits<T>::infinity() }
+{
+  m_weights.reserve(m_parameters.size());
+  for (BasicVariable<T>* param : m_parameters)
+    m_weights.push_back(BasicScalar<T>::value(*param));
+  m_gradients.assign(m_parameters.size(), T{0});
+}
+
+template <typename T>
+template <typename F>
+void BasicOptimizer<T>::forChunks(F&& body) const
+{
+  const std::size_t n{ m_parameters.size() };
+  const std::size_t chunks{ (n + chunkSize - 1) / chunkSize };
+  const ParallelOptions& parallel{ m_options.parallel };
+  auto chunk{ [&](std::size_t c) { body(c * chunkSize, std::min(n, (c + 1) * chunkSize)); } };
+  if (n < parallel.threshold || chunks < 2 || parallel.concurrency() <= 1) {
+    for (std::size_t c{0}; c < chunks; ++c)
+      chunk(c);
+    return;
+  }
+  // The chunks are handed out through a counter, since a busy pool may run the job on the
+  // calling thread alone.
+  std::atomic<std::size_t> next{ 0 };
+  parallel.getPool().run(std::min(parallel.concurrency(), chunks), [&](std::size_t) {
+    for (std::size_t c{ next++ }; c < chunks; c = next++)
+      chunk(c);
+  });
+}
+
+template <typename T>
+T BasicOptimizer<T>::step(std::span<const T> inputValues)
+{
+  const auto grad_table{ m_unit.gradients(inputValues) };
+  const T loss{ BasicScalar<T>::value(m_unit.getOutput()) };
+  for (std::size_t i{0}; i < m_parameters.size(); ++i) {
+    const auto it{ grad_table.find(m_parameters[i]) };
+    // A parameter the output does not depend on has no gradient.
+    m_gradients[i] = (it == grad_table.end()) ? T{0} : it->second[0];
+  }
+  apply(m_gradients);
+  return loss;
+}
+
+template <typename T>
+void BasicOptimizer<T>::apply(std::span<const T> gradients)
+{
+  if (gradients.size() != m_parameters.size())
+    throw InvalidOperationException("An optimizer needs one gradient per parameter.");
+  if (gradients.data() != m_gradients.data())
+    std::copy(gradients.begin(), gradients.end(), m_gradients.begin());
+
+  T scale{ 1 };
+  if (m_options.clipNorm > 0) {
+    // Per chunk sums added in order, so that the norm does not depend on the threads.
+    std::vector<T> sums((m_parameters.size() + chunkSize - 1) / chunkSize, T{0});
+    forChunks([&](std::size_t begin, std::size_t end) {
+      T sum{ 0 };
+      for (std::size_t i{begin}; i < end; ++i)
+	sum += m_gradients[i] * m_gradients[i];
+      sums[begin / chunkSize] = sum;
+    });
+    T squared{ 0 };
+    for (const T sum : sums)
+      squared += sum;
+    const T norm{ std::sqrt(squared) };
+    if (norm > static_cast<T>(m_options.clipNorm))
+      scale = static_cast<T>(m_options.clipNorm) / norm;
+  }
+
+  prepare(++m_steps);
+  forChunks([&](std::size_t begin, std::size_t end) {
+    update(begin, end, scale);
+    for (std::size_t i{begin}; i < end; ++i)
+      BasicScalar<T>::setValue(*m_parameters[i], m_weights[i]);
+  });
+}
+
+template <typename T>
+void BasicSGD<T>::update(std::size_t begin, std::size_t end, T scale)
+{
+  T* w{ this->m_weights.data() };
+  for (std::size_t i{begin}; i < end; ++i)
+    w[i] -= this->m_learningRate * this->prepared(i, scale);
+}
+
+template <typename T>
+BasicMomentum<T>::BasicMomentum(BasicUnit<T>& unit, const OptimizerOptions& options,
+				double momentum)
+  : BasicOptimizer<T>{ unit, options }
+  , m_velocity(this->m_weights.size(), T{0})
+  , m_momentum{ static_cast<T>(momentum) }
+{}
+
+template <typename T>
+void BasicMomentum<T>::update(std::size_t begin, std::size_t end, T scale)
+{
+  T* w{ this->m_weights.data() };
+  T* v{ m_velocity.data() };
+  for (std::size_t i{begin}; i < end; ++i) {
+    v[i] = m_momentum * v[i] + this->prepared(i, scale);
+    w[i] -= this->m_learningRate * v[i];
+  }
+}
+
+template <typename T>
+BasicRMSProp<T>::BasicRMSProp(BasicUnit<T>& unit, const OptimizerOptions& options,
+			      double decay, double epsilon)
+  : BasicOptimizer<T>{ unit, options }
+  , m_square(this->m_weights.size(), T{0})
+  , m_decay{ static_cast<T>(decay) }
+  , m_epsilon{ static_cast<T>(epsilon) }
+{}
+
+template <typename T>
+void BasicRMSProp<T>::update(std::size_t begin, std::size_t end, T scale)
+{
+  T* w{ this->m_weights.data() };
+  T* s{ m_square.data() };
+  for (std::size_t i{begin}; i < end; ++i) {
+    const T g{ this->prepared(i, scale) };
+    s[i] = m_decay * s[i] + (T{1} - m_decay) * g * g;
+    w[i] -= this->m_learningRate * g / (std::sqrt(s[i]) + m_epsilon);
+  }
+}
+
+template <typename T>
+BasicAdam<T>::BasicAdam(BasicUnit<T>& unit, const OptimizerOptions& options,
+			double beta1, double beta2, double epsilon)
+  : BasicOptimizer<T>{ unit, options }
+  , m_mean(this->m_weights.size(), T{0})
+  , m_square(this->m_weights.size(), T{0})
+  , m_beta1{ static_cast<T>(beta1) }
+  , m_beta2{ static_cast<T>(beta2) }
+  , m_epsilon{ static_cast<T>(epsilon) }
+{}
+
+template <typename T>
+void BasicAdam<T>::prepare(std::size_t step)
+{
+  // The averages start at 0 and are biased towards it for the first steps.
+  const T t{ static_cast<T>(step) };
+  m_stepSize = this->m_learningRate / (T{1} - std::pow(m_beta1, t));
+  m_squareCorrection = T{1} / (T{1} - std::pow(m_beta2, t));
+}
+
+template <typename T>
+void BasicAdam<T>::update(std::size_t begin, std::size_t end, T scale)
+{
+  T* w{ this->m_weights.data() };
+  T* m{ m_mean.data() };
+  T* v{ m_square.data() };
+  for (std::size_t i{begin}; i < end; ++i) {
+    const T g{ this->prepared(i, scale) };
+    m[i] = m_beta1 * m[i] + (T{1} - m_beta1) * g;
+    v[i] = m_beta2 * v[i] + (T{1} - m_beta2) * g * g;
+    w[i] -= m_stepSize * m[i] / (std::sqrt(v[i] * m_squareCorrection) + m_epsilon);
+  }
+}
+
+template class BasicOptimizer<float>;
+template class BasicOptimizer<double>;
+template class BasicOptimizer<long double>;
+
+template class BasicSGD<float>;
+template class BasicSGD<double>;
+template class BasicSGD<long double>;
+
+template class BasicMomentum<float>;
+template class BasicMomentum<double>;
+template class BasicMomentum<long double>;
+
+template class BasicRMSProp<float>;
+template class BasicRMSProp<double>;
+template class BasicRMSProp<long double>;
+
+template class BasicAdam<float>;
+template class BasicAdam<double>;
+template class BasicAdam<long double>;
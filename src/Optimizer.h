@@ -0,0 +1,213 @@
+// First order optimizers for the parameters of a Unit.
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "Unit.h"
+#include "Variable.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Settings shared by all optimizers.
+ * @param learningRate The step size.
+ * @param weightDecay L2 regularization, weightDecay * w is added to the gradient of every
+ *                    parameter w before the update.
+ * @param clipValue Every gradient is clamped to [-clipValue, clipValue], 0 meaning no clipping.
+ * @param clipNorm The gradients are scaled down so that their L2 norm is at most clipNorm, 0
+ *                 meaning no clipping. Needs a pass over the gradients before the update.
+ * @param parallel Units with at least parallel.threshold parameters are updated in chunks on
+ *                 several threads. The default threshold is higher than for the engines,
+ *                 since an update does little work per parameter.
+ */
+struct OptimizerOptions
+{
+  double learningRate{ 0.01 };
+  double weightDecay{ 0.0 };
+  double clipValue{ 0.0 };
+  double clipNorm{ 0.0 };
+  ParallelOptions parallel{ 0, 1 << 16 };
+};
+
+/**
+ * The parameters of the unit, see BasicUnit::getParameters, are gathered into one contiguous
+ * buffer when the optimizer is created, and so are their gradients on every step. The update
+ * of each optimizer is a single fused loop over these buffers, applying the weight decay,
+ * clipping and the update rule at once, which the compiler vectorizes. The updated values are
+ * written back into the unit, so only the variables that depend on the parameters are
+ * recomputed by the next forward pass.
+ * @brief Base class of the optimizers, see BasicSGD, BasicMomentum, BasicRMSProp and BasicAdam.
+ * @note The buffer is the master copy of the parameters. Parameters changed through the unit
+ *       are overwritten by the next step.
+ */
+template <typename T>
+class BasicOptimizer
+{
+private:
+  BasicUnit<T>& m_unit;
+  std::vector<BasicVariable<T>*> m_parameters{};
+  OptimizerOptions m_options{};
+  std::size_t m_steps{ 0 };
+
+  /* Runs body(begin, end) over chunks of the parameters, on several threads for large units. */
+  template <typename F>
+  void forChunks(F&& body) const;
+
+protected:
+  static constexpr std::size_t chunkSize{ 4096 };
+
+  std::vector<T> m_weights{};
+  std::vector<T> m_gradients{};
+  T m_learningRate{};
+  T m_weightDecay{};
+  T m_clip{};
+
+  /**
+   * @brief The gradient after the weight decay and clipping, for the update rules.
+   * @param scale Scales the raw gradient, see OptimizerOptions::clipNorm.
+   */
+  T prepared(std::size_t i, T scale) const
+  {
+    const T g{ m_gradients[i] * scale + m_weightDecay * m_weights[i] };
+    return std::clamp(g, -m_clip, m_clip);
+  }
+
+  /**
+   * @brief Called once per step before the updates, i.e. for the bias correction of Adam.
+   * @param step The number of the step, starting at 1.
+   */
+  virtual void prepare(std::size_t /*step*/)
+  {}
+
+  /**
+   * @brief Applies the update rule to the parameters [begin, end). Chunks do not overlap and
+   *        may be updated concurrently.
+   */
+  virtual void update(std::size_t begin, std::size_t end, T scale) = 0;
+
+public:
+  using value_type = T;
+
+  BasicOptimizer(BasicUnit<T>& unit, const OptimizerOptions& options);
+  virtual ~BasicOptimizer() = default;
+
+  /**
+   * @brief Forward and backward propagates the inputs and updates the parameters.
+   * @param inputValues One value per input of the unit, in the order of getInputs().
+   * @return The output of the unit, i.e. the loss, before the update.
+   */
+  T step(std::span<const T> inputValues);
+
+  /**
+   * @brief Updates the parameters with gradients computed elsewhere.
+   * @param gradients One gradient per parameter, in the order of getParameters().
+   */
+  void apply(std::span<const T> gradients);
+
+  /** @brief The parameters in the order of the buffers. */
+  const std::vector<BasicVariable<T>*>& getParameters() const
+  { return m_parameters; }
+
+  /** @brief The current values of the parameters. */
+  const std::vector<T>& getWeights() const
+  { return m_weights; }
+
+  /** @brief The gradients of the last step, before weight decay and clipping. */
+  const std::vector<T>& getGradients() const
+  { return m_gradients; }
+
+  /** @brief The number of updates applied so far. */
+  std::size_t getSteps() const
+  { return m_steps; }
+};
+
+/**
+ * @brief Plain gradient descent, w -= learningRate * g.
+ */
+template <typename T>
+class BasicSGD final : public BasicOptimizer<T>
+{
+protected:
+  void update(std::size_t begin, std::size_t end, T scale) override;
+
+public:
+  explicit BasicSGD(BasicUnit<T>& unit, const OptimizerOptions& options={})
+    : BasicOptimizer<T>{ unit, options }
+  {}
+};
+
+/**
+ * @brief Gradient descent with momentum, v = momentum * v + g and w -= learningRate * v.
+ */
+template <typename T>
+class BasicMomentum final : public BasicOptimizer<T>
+{
+private:
+  std::vector<T> m_velocity{};
+  T m_momentum{};
+
+protected:
+  void update(std::size_t begin, std::size_t end, T scale) override;
+
+public:
+  explicit BasicMomentum(BasicUnit<T>& unit, const OptimizerOptions& options={},
+			 double momentum=0.9);
+};
+
+/**
+ * @brief Scales the step of every parameter by a running average of its squared gradients,
+ *        s = decay * s + (1 - decay) * g^2 and w -= learningRate * g / (sqrt(s) + epsilon).
+ */
+template <typename T>
+class BasicRMSProp final : public BasicOptimizer<T>
+{
+private:
+  std::vector<T> m_square{};
+  T m_decay{};
+  T m_epsilon{};
+
+protected:
+  void update(std::size_t begin, std::size_t end, T scale) override;
+
+public:
+  explicit BasicRMSProp(BasicUnit<T>& unit, const OptimizerOptions& options={},
+			double decay=0.9, double epsilon=1e-8);
+};
+
+/**
+ * Keeps running averages of the gradients, m, and of their squares, v, and steps by the bias
+ * corrected m / (sqrt(v) + epsilon).
+ * @brief The Adam optimizer.
+ */
+template <typename T>
+class BasicAdam final : public BasicOptimizer<T>
+{
+private:
+  std::vector<T> m_mean{};
+  std::vector<T> m_square{};
+  T m_beta1{};
+  T m_beta2{};
+  T m_epsilon{};
+  T m_stepSize{};          // The learning rate with the bias correction of m.
+  T m_squareCorrection{};  // The bias correction of v.
+
+protected:
+  void prepare(std::size_t step) override;
+  void update(std::size_t begin, std::size_t end, T scale) override;
+
+public:
+  explicit BasicAdam(BasicUnit<T>& unit, const OptimizerOptions& options={},
+		     double beta1=0.9, double beta2=0.999, double epsilon=1e-8);
+};
+
+using SGD = BasicSGD<double>;
+using Momentum = BasicMomentum<double>;
+using RMSProp = BasicRMSProp<double>;
+using Adam = BasicAdam<double>;
+
+#endif
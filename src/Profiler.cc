@@ -0,0 +1,203 @@
+#include "Profiler.h"
+#include "operation_constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+  /**
+   * @brief The events of one thread. The lock is only contended while the trace is read.
+   */
+  struct TraceBuffer
+  {
+    std::mutex mutex{};
+    std::vector<TraceEvent> events{};
+    std::uint32_t thread{ 0 };
+  };
+
+  /**
+   * @brief All buffers ever created, kept alive after their thread exits.
+   */
+  struct TraceRegistry
+  {
+    std::mutex mutex{};
+    std::vector<std::shared_ptr<TraceBuffer>> buffers{};
+  };
+
+  TraceRegistry& registry()
+  {
+    static TraceRegistry s_registry{};
+    return s_registry;
+  }
+
+  TraceBuffer& localBuffer()
+  {
+    thread_local std::shared_ptr<TraceBuffer> t_buffer{ [] {
+      auto buffer{ std::make_shared<TraceBuffer>() };
+      TraceRegistry& reg{ registry() };
+      const std::lock_guard lock{ reg.mutex };
+      buffer->thread = static_cast<std::uint32_t>(reg.buffers.size());
+      reg.buffers.push_back(buffer);
+      return buffer;
+    }() };
+    return *t_buffer;
+  }
+
+  const char* phaseName(ProfilePhase phase)
+  { return (phase == ProfilePhase::Forward) ? "forward" : "backward"; }
+}
+
+OpProfile ProfileReport::total(ProfilePhase phase) const
+{
+  OpProfile sum{};
+  for (const OpProfile& op : ops[static_cast<std::size_t>(phase)]) {
+    sum.calls += op.calls;
+    sum.nanoseconds += op.nanoseconds;
+    sum.bytes += op.bytes;
+    sum.allocations += op.allocations;
+  }
+  return sum;
+}
+
+std::ostream& operator<<(std::ostream& out, const ProfileReport& report)
+{
+  out << std::left << std::setw(10) << "phase" << std::setw(12) << "operation"
+      << std::right << std::setw(12) << "calls" << std::setw(14) << "time [us]"
+      << std::setw(14) << "bytes" << std::setw(14) << "allocations" << '\n';
+  for (std::size_t p{0}; p < ProfileReport::phaseCount; ++p) {
+    for (std::size_t c{0}; c < ProfileReport::opCount; ++c) {
+      const OpProfile& op{ report.ops[p][c] };
+      if (op.calls == 0)
+	continue;
+      std::ostringstream name{};
+      name << operationOf<double>(static_cast<OpCode>(c));
+      out << std::left << std::setw(10) << phaseName(static_cast<ProfilePhase>(p))
+	  << std::setw(12) << name.str()
+	  << std::right << std::setw(12) << op.calls
+	  << std::setw(14) << static_cast<double>(op.nanoseconds) / 1000.0
+	  << std::setw(14) << op.bytes << std::setw(14) << op.allocations << '\n';
+    }
+    const OpProfile sum{ report.total(static_cast<ProfilePhase>(p)) };
+    out << std::left << std::setw(10) << phaseName(static_cast<ProfilePhase>(p))
+	<< std::setw(12) << "total"
+	<< std::right << std::setw(12) << sum.calls
+	<< std::setw(14) << static_cast<double>(sum.nanoseconds) / 1000.0
+	<< std::setw(14) << sum.bytes << std::setw(14) << sum.allocations << "  (" << report.visits[p] << " node visits)\n";
+  }
+  return out;
+}
+
+void Profiler::reset()
+{
+  for (auto& phase : s_ops)
+    for (auto& op : phase)
+      for (Counter& counter : op)
+	counter.store(0, std::memory_order_relaxed);
+  for (Counter& counter : s_visits)
+    counter.store(0, std::memory_order_relaxed);
+}
+
+ProfileReport Profiler::report()
+{
+  ProfileReport report{};
+  for (std::size_t p{0}; p < ProfileReport::phaseCount; ++p) {
+    for (std::size_t c{0}; c < ProfileReport::opCount; ++c) {
+      report.ops[p][c].calls = s_ops[p][c][0].load(std::memory_order_relaxed);
+      report.ops[p][c].nanoseconds = s_ops[p][c][1].load(std::memory_order_relaxed);
+      report.ops[p][c].bytes = s_ops[p][c][2].load(std::memory_order_relaxed);
+      report.ops[p][c].allocations = s_ops[p][c][3].load(std::memory_order_relaxed);
+    }
+    report.visits[p] = s_visits[p].load(std::memory_order_relaxed);
+  }
+  return report;
+}
+
+void Profiler::record(ProfilePhase phase, OpCode code, std::uint64_t nanoseconds,
+		      std::size_t bytes, std::uint64_t allocations)
+{
+  auto& op{ s_ops[static_cast<std::size_t>(phase)][static_cast<std::size_t>(code)] };
+  op[0].fetch_add(1, std::memory_order_relaxed);
+  op[1].fetch_add(nanoseconds, std::memory_order_relaxed);
+  op[2].fetch_add(bytes, std::memory_order_relaxed);
+  op[3].fetch_add(allocations, std::memory_order_relaxed);
+}
+
+std::int64_t Profiler::now()
+{
+  using Clock = std::chrono::steady_clock;
+  static const Clock::time_point s_epoch{ Clock::now() };
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - s_epoch).count();
+}
+
+void Profiler::trace(const TraceEvent& event)
+{
+  TraceBuffer& buffer{ localBuffer() };
+  const std::lock_guard lock{ buffer.mutex };
+  buffer.events.push_back(event);
+  buffer.events.back().thread = buffer.thread;
+}
+
+void Profiler::clearTrace()
+{
+  TraceRegistry& reg{ registry() };
+  const std::lock_guard lock{ reg.mutex };
+  for (const auto& buffer : reg.buffers) {
+    const std::lock_guard bufferLock{ buffer->mutex };
+    buffer->events.clear();
+  }
+}
+
+std::vector<TraceEvent> Profiler::traceEvents()
+{
+  std::vector<TraceEvent> events{};
+  {
+    TraceRegistry& reg{ registry() };
+    const std::lock_guard lock{ reg.mutex };
+    for (const auto& buffer : reg.buffers) {
+      const std::lock_guard bufferLock{ buffer->mutex };
+      events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+    }
+  }
+  std::stable_sort(events.begin(), events.end(), [](const TraceEvent& e1, const TraceEvent& e2) {
+    return e1.start < e2.start;
+  });
+  return events;
+}
+
+void Profiler::writeTrace(std::ostream& out)
+{
+  // Timestamps and durations are in microseconds, with the nanoseconds kept as decimals.
+  auto micros{ [&out](std::int64_t nanoseconds) {
+    out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000
+	<< std::setfill(' ');
+  }};
+  out << "{\"traceEvents\":[";
+  bool first{ true };
+  for (const TraceEvent& event : traceEvents()) {
+    std::ostringstream name{};
+    name << operationOf<double>(event.code);
+    out << (first ? "\n" : ",\n") << "{\"name\":\"" << name.str() << "\",\"cat\":\""
+	<< phaseName(event.phase) << "\",\"ph\":\"X\",\"ts\":";
+    micros(event.start);
+    out << ",\"dur\":";
+    micros(event.duration);
+    out << ",\"pid\":1,\"tid\":" << event.thread << ",\"args\":{\"node\":\"0x"
+	<< std::hex << event.node << std::dec << "\"}}";
+    first = false;
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void Profiler::saveTrace(const std::string& path)
+{
+  std::ofstream file{ path };
+  if (!file)
+    throw InvalidOperationException("Could not open " + path + " for writing.");
+  writeTrace(file);
+}
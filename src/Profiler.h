@@ -0,0 +1,245 @@
+// Opt-in counters, timers and traces for the forward and backward engines.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Operation.h"
+#include "AllocationCounter.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Building with AUTODIFF_PROFILING=0 removes the instrumentation altogether.
+#ifndef AUTODIFF_PROFILING
+#define AUTODIFF_PROFILING 1
+#endif
+
+/**
+ * @brief The engine a measurement was taken in.
+ */
+enum class ProfilePhase : std::uint8_t
+{
+  Forward,
+  Backward,
+};
+
+/**
+ * Bytes touched are the values read and written by the kernel, i.e. the operands and the
+ * result of a forward evaluation and in addition the incoming gradient of a bprop call.
+ * Allocations are the heap allocations made during the calls, which are only counted when
+ * the counting operator new is linked in, see AllocationCounter.
+ * @brief Totals for one operation in one phase.
+ */
+struct OpProfile
+{
+  std::uint64_t calls{ 0 };
+  std::uint64_t nanoseconds{ 0 };
+  std::uint64_t bytes{ 0 };
+  std::uint64_t allocations{ 0 };
+};
+
+/**
+ * Node visits count every time an engine reaches a variable, whether or not it is computed.
+ * The recursive forwardProp visits a shared variable once per path to it, so visits well above
+ * the forward calls point at repeated work.
+ * @brief A snapshot of the profiling counters, see Profiler::report.
+ */
+struct ProfileReport
+{
+  static constexpr std::size_t opCount{ static_cast<std::size_t>(OpCode::ScalarAbs) + 1 };
+  static constexpr std::size_t phaseCount{ 2 };
+
+  std::array<std::array<OpProfile, opCount>, phaseCount> ops{};
+  std::array<std::uint64_t, phaseCount> visits{};
+
+  const OpProfile& get(ProfilePhase phase, OpCode code) const
+  { return ops[static_cast<std::size_t>(phase)][static_cast<std::size_t>(code)]; }
+
+  std::uint64_t getVisits(ProfilePhase phase) const
+  { return visits[static_cast<std::size_t>(phase)]; }
+
+  /**
+   * @brief The sum over all operations of a phase.
+   */
+  OpProfile total(ProfilePhase phase) const;
+
+  /**
+   * @brief A table with one row per operation and phase that was called.
+   */
+  friend std::ostream& operator<<(std::ostream& out, const ProfileReport& report);
+};
+
+/**
+ * @brief One kernel call in a trace. Times are in nanoseconds, see Profiler::now.
+ * @param thread A small number given to each thread on its first event.
+ * @param node The address of the variable computed or differentiated.
+ */
+struct TraceEvent
+{
+  std::int64_t start{ 0 };
+  std::int64_t duration{ 0 };
+  std::uintptr_t node{ 0 };
+  std::uint32_t thread{ 0 };
+  ProfilePhase phase{ ProfilePhase::Forward };
+  OpCode code{ OpCode::Input };
+};
+
+/**
+ * The counters are global and shared by all graphs, precisions and threads. Profiling is off
+ * until enabled, and then costs a relaxed load per evaluated node.
+ * @brief Per-operation call counts, wall time and bytes touched.
+ */
+class Profiler
+{
+private:
+  using Counter = std::atomic<std::uint64_t>;
+
+  inline static std::atomic<bool> s_enabled{ false };
+  inline static std::atomic<bool> s_tracing{ false };
+  inline static std::array<std::array<std::array<Counter, 4>, ProfileReport::opCount>,
+			   ProfileReport::phaseCount> s_ops{};
+  inline static std::array<Counter, ProfileReport::phaseCount> s_visits{};
+
+public:
+  static void enable(bool on=true)
+  { s_enabled.store(on, std::memory_order_relaxed); }
+
+  static void disable()
+  { enable(false); }
+
+  static bool isEnabled()
+  {
+#if AUTODIFF_PROFILING
+    return s_enabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Sets all counters to zero.
+   */
+  static void reset();
+
+  /**
+   * @brief The counters so far. Calls still running on other threads may be missing.
+   */
+  static ProfileReport report();
+
+  static void record(ProfilePhase phase, OpCode code, std::uint64_t nanoseconds,
+		     std::size_t bytes, std::uint64_t allocations);
+
+  /**
+   * Events are buffered per thread until written, so a trace should be kept to a few passes.
+   * @brief Starts recording one event per kernel call, see writeTrace.
+   */
+  static void startTrace()
+  { s_tracing.store(true, std::memory_order_relaxed); }
+
+  static void stopTrace()
+  { s_tracing.store(false, std::memory_order_relaxed); }
+
+  static bool isTracing()
+  {
+#if AUTODIFF_PROFILING
+    return s_tracing.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief Drops the recorded events.
+   */
+  static void clearTrace();
+
+  /**
+   * @brief The recorded events of all threads, ordered by start time.
+   */
+  static std::vector<TraceEvent> traceEvents();
+
+  /**
+   * The events are complete events, "ph":"X", named after the operation and with the phase as
+   * category. The node is the address of the variable, which is the same in every engine.
+   * Load the output in chrome://tracing or Perfetto.
+   * @brief Writes the recorded events in the Chrome trace-event JSON format.
+   */
+  static void writeTrace(std::ostream& out);
+
+  /**
+   * @brief Writes the trace to a file, see writeTrace.
+   */
+  static void saveTrace(const std::string& path);
+
+  static void trace(const TraceEvent& event);
+
+  /**
+   * @brief Nanoseconds since the first use of the profiler, the time base of the trace.
+   */
+  static std::int64_t now();
+
+  static void countVisit(ProfilePhase phase)
+  {
+    if (isEnabled())
+      s_visits[static_cast<std::size_t>(phase)].fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+/**
+ * @brief Times one kernel call from construction to destruction, if profiling or tracing is on.
+ */
+class ProfileScope
+{
+private:
+  bool m_counting{ Profiler::isEnabled() };
+  bool m_tracing{ Profiler::isTracing() };
+  ProfilePhase m_phase;
+  OpCode m_code{ OpCode::Input };
+  const void* m_node{ nullptr };
+  std::size_t m_bytes{ 0 };
+  std::int64_t m_start{ 0 };
+  std::uint64_t m_allocations{ 0 };
+
+public:
+  /**
+   * @param operation Asked for its op code only when profiling is on.
+   * @param node The variable computed or differentiated, used to identify it in a trace.
+   * @param bytes The bytes touched by the call.
+   */
+  template <typename T>
+  ProfileScope(ProfilePhase phase, const BasicOperation<T>& operation, const void* node,
+	       std::size_t bytes)
+    : m_phase{ phase }
+  {
+    if (m_counting || m_tracing) {
+      m_code = operation.getOpCode();
+      m_node = node;
+      m_bytes = bytes;
+      m_allocations = AllocationCounter::threadAllocations();
+      m_start = Profiler::now();
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+  ~ProfileScope()
+  {
+    if (!m_counting && !m_tracing)
+      return;
+    const std::int64_t duration{ Profiler::now() - m_start };
+    if (m_counting)
+      Profiler::record(m_phase, m_code, static_cast<std::uint64_t>(duration), m_bytes,
+		       AllocationCounter::threadAllocations() - m_allocations);
+    if (m_tracing)
+      Profiler::trace(TraceEvent{ m_start, duration, reinterpret_cast<std::uintptr_t>(m_node),
+				  0, m_phase, m_code });
+  }
+};
+
+#endif
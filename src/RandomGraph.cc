@@ -0,0 +1,148 @@
+#include "RandomGraph.h"
+#include "Scalar.h"
+#include "OperationUnary.h"
+#include "OperationBinary.h"
+#include "operation_constants.h"
+#include "forwardProp.h"
+#include "ExecutionPlan.h"
+#include "CompactGraph.h"
+#include "Unit.h"
+#include "Exceptions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace
+{
+  /* A uniform value in [0, 1) which, unlike the standard distributions, is the same for
+     every standard library. */
+  double uniform(std::mt19937_64& rng)
+  { return static_cast<double>(rng() >> 11) * 0x1.0p-53; }
+}
+
+template <typename T>
+BasicRandomGraph<T> randomGraph(const RandomGraphOptions& options)
+{
+  if (options.inputs == 0)
+    throw InvalidOperationException("A random graph needs at least one input.");
+  double totalWeight{ 0 };
+  for (const auto& [code, weight] : options.ops) {
+    if (code == OpCode::Input || weight < 0)
+      throw InvalidOperationException("The op mix may only hold operations with weights >= 0.");
+    totalWeight += weight;
+  }
+  if (totalWeight <= 0 && options.depth > 0)
+    throw InvalidOperationException("The op mix of a random graph is empty.");
+
+  BasicRandomGraph<T> result{};
+  auto& graph{ result.graph };
+  std::mt19937_64 rng{ options.seed };
+  std::vector<BasicVariable<T>*> all{};
+  std::vector<std::size_t> consumers{};
+  auto keep{ [&](std::unique_ptr<BasicVariable<T>> var) {
+    all.push_back(var.get());
+    consumers.push_back(0);
+    result.variables.push_back(std::move(var));
+    return all.back();
+  }};
+  for (std::size_t i{0}; i < options.inputs; ++i) {
+    const T value{ static_cast<T>(0.5 + uniform(rng)) };
+    BasicVariable<T>* x{ keep(std::make_unique<BasicScalar<T>>("x" + std::to_string(i),
+							      basicInput<T>, value)) };
+    graph.addNode(x);
+    result.inputs.push_back(x);
+  }
+
+  // Variables [previousBegin, previousEnd) are the layer right before the current one.
+  std::size_t previousBegin{ 0 };
+  std::size_t previousEnd{ all.size() };
+  auto pick{ [&]() {
+    const std::size_t begin{ (uniform(rng) < options.sharing) ? 0 : previousBegin };
+    const std::size_t n{ previousEnd - begin };
+    const double u{ std::pow(uniform(rng), 1.0 + options.fanOutSkew) };
+    std::size_t k{ begin + std::min(n - 1, static_cast<std::size_t>(u * static_cast<double>(n))) };
+    if (options.maxFanOut != 0 && consumers[k] >= options.maxFanOut) {
+      // The next variable with room, first in the layer before and then in any earlier one.
+      auto search{ [&](std::size_t first, std::size_t last) {
+	for (std::size_t j{0}; j < last - first; ++j) {
+	  const std::size_t candidate{ first + (k - first + j + 1) % (last - first) };
+	  if (consumers[candidate] < options.maxFanOut)
+	    return candidate;
+	}
+	return previousEnd;
+      }};
+      std::size_t found{ (k >= previousBegin) ? search(previousBegin, previousEnd) : previousEnd };
+      if (found == previousEnd)
+	found = search(0, previousEnd);
+      if (found == previousEnd)
+	throw InvalidOperationException("maxFanOut is too small for the width of the random graph.");
+      k = found;
+    }
+    ++consumers[k];
+    return all[k];
+  }};
+
+  for (std::size_t layer{0}; layer < options.depth; ++layer) {
+    for (std::size_t w{0}; w < options.width; ++w) {
+      double draw{ uniform(rng) * totalWeight };
+      OpCode code{ options.ops.back().first };
+      for (const auto& [candidate, weight] : options.ops) {
+	if (draw < weight) {
+	  code = candidate;
+	  break;
+	}
+	draw -= weight;
+      }
+      const BasicOperation<T>& operation{ operationOf<T>(code) };
+      if (operation.isBinary()) {
+	BasicVariable<T>* left{ pick() };
+	BasicVariable<T>* right{ pick() };
+	keep(static_cast<const BasicOperationBinary<T>&>(operation)(graph, *left, *right));
+      } else {
+	keep(static_cast<const BasicOperationUnary<T>&>(operation)(graph, *pick()));
+      }
+    }
+    previousBegin = previousEnd;
+    previousEnd = all.size();
+  }
+
+  // The leafs are only outputs of a graph without operations.
+  const std::size_t first{ (options.depth == 0) ? 0 : options.inputs };
+  for (std::size_t k{first}; k < all.size(); ++k)
+    if (consumers[k] == 0)
+      result.outputs.push_back(all[k]);
+  if (options.singleOutput) {
+    auto level{ std::move(result.outputs) };
+    while (level.size() > 1) {
+      std::vector<BasicVariable<T>*> next{};
+      for (std::size_t i{0}; i + 1 < level.size(); i += 2)
+	next.push_back(keep(basicScalarAdd<T>(graph, *level[i], *level[i + 1])));
+      if (level.size() % 2 == 1)
+	next.push_back(level.back());
+      level = std::move(next);
+    }
+    result.outputs = std::move(level);
+  }
+  return result;
+}
+
+template <typename T>
+BasicUnit<T> randomUnit(const RandomGraphOptions& options)
+{
+  RandomGraphOptions single{ options };
+  single.singleOutput = true;
+  BasicRandomGraph<T> generated{ randomGraph<T>(single) };
+  forwardProp(generated.graph, generated.outputs);
+  const ExecutionPlan<T> plan{ generated.graph, generated.outputs, generated.inputs };
+  return BasicUnit<T>{ CompactGraph<T>{ plan } };
+}
+
+template BasicRandomGraph<float> randomGraph(const RandomGraphOptions&);
+template BasicRandomGraph<double> randomGraph(const RandomGraphOptions&);
+template BasicRandomGraph<long double> randomGraph(const RandomGraphOptions&);
+
+template BasicUnit<float> randomUnit(const RandomGraphOptions&);
+template BasicUnit<double> randomUnit(const RandomGraphOptions&);
+template BasicUnit<long double> randomUnit(const RandomGraphOptions&);
@@ -0,0 +1,85 @@
+// Random computational graphs for benchmarks and stress tests.
+
+#ifndef RANDOM_GRAPH_H
+#define RANDOM_GRAPH_H
+
+#include "DirectedGraph.h"
+#include "Variable.h"
+#include "Operation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class BasicUnit;
+
+/**
+ * The graph is built in layers. Layer 0 holds the named inputs x0, x1, ... and every later
+ * layer holds width operations whose operands come from earlier layers.
+ * @brief The shape of a random graph, see randomGraph.
+ * @param seed Equal options and seeds give the same graph.
+ * @param depth The number of layers of operations, i.e. the longest path from an input.
+ * @param width The number of operations per layer.
+ * @param ops The op mix as pairs of operation and relative weight. The arity of the
+ *            operations gives the fan-in, one for unary and two for binary operations.
+ * @param sharing The probability that an operand is drawn from any earlier layer instead of
+ *                the layer right before. 0 gives a strictly layered graph.
+ * @param fanOutSkew 0 draws operands uniformly. Larger values prefer the first variables of a
+ *                   layer, which then become hubs with a large fan-out.
+ * @param maxFanOut No variable gets more consumers, 0 meaning no limit. Operands are redrawn
+ *                  from the layer right before when the limit is hit.
+ * @param singleOutput Sum the sinks pairwise into a single output, as a Unit requires.
+ */
+struct RandomGraphOptions
+{
+  std::uint64_t seed{ 1 };
+  std::size_t inputs{ 4 };
+  std::size_t depth{ 8 };
+  std::size_t width{ 16 };
+  std::vector<std::pair<OpCode, double>> ops{
+    { OpCode::ScalarAdd, 1.0 }, { OpCode::ScalarSub, 1.0 },
+    { OpCode::ScalarMul, 1.0 }, { OpCode::ScalarAbs, 0.5 } };
+  double sharing{ 0.25 };
+  double fanOutSkew{ 0.0 };
+  std::size_t maxFanOut{ 0 };
+  bool singleOutput{ false };
+};
+
+/**
+ * @brief A generated graph together with the variables it points to.
+ * @param inputs The leafs, in order of their names.
+ * @param outputs The variables without consumers, or the single sum of them.
+ */
+template <typename T>
+struct BasicRandomGraph
+{
+  DirectedGraph<BasicVariable<T>*> graph{};
+  std::vector<std::unique_ptr<BasicVariable<T>>> variables{};
+  std::vector<BasicVariable<T>*> inputs{};
+  std::vector<BasicVariable<T>*> outputs{};
+};
+
+using RandomGraph = BasicRandomGraph<double>;
+
+/**
+ * The inputs are given values in [0.5, 1.5). The values of the operations are not computed,
+ * forward propagate before using them. Op codes without an operation, i.e. Input, are
+ * rejected with an InvalidOperationException.
+ * @brief Generates a random graph directly into a DirectedGraph.
+ */
+template <typename T>
+BasicRandomGraph<T> randomGraph(const RandomGraphOptions& options);
+
+/**
+ * Operations on units cannot share intermediate variables, so the graph is generated with
+ * randomGraph and rebuilt as a unit through its compact form. The sinks are always summed
+ * into a single output and the inputs become the inputs of the unit.
+ * @brief Generates a random unit.
+ */
+template <typename T>
+BasicUnit<T> randomUnit(const RandomGraphOptions& options);
+
+#endif
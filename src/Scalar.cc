@@ -6,48 +6,74 @@
 #include <memory>
 #include <string>
 
-Scalar::Scalar(const std::string& name, const Operation& operation, double value, bool flag)
-  : Variable{ name, operation, flag }
+template <typename T>
+BasicScalar<T>::BasicScalar(const std::string& name, const BasicOperation<T>& operation,
+			    T value, bool flag)
+  : BasicVariable<T>{ name, operation, flag }
 {
-  m_memory = std::make_unique<double>(value);
+  this->m_memory = std::make_unique<T>(value);
 }
 
-Scalar::Scalar(const Operation& operation, double value, bool flag)
-  : Variable{ operation, flag }
+template <typename T>
+BasicScalar<T>::BasicScalar(SymbolTable::Symbol symbol, const BasicOperation<T>& operation,
+			    T value, bool flag)
+  : BasicVariable<T>{ symbol, operation, flag }
 {
-  m_memory = std::make_unique<double>(value);
+  this->m_memory = std::make_unique<T>(value);
 }
 
-double Scalar::add(const Scalar& rscalar) const
+template <typename T>
+BasicScalar<T>::BasicScalar(const BasicOperation<T>& operation, T value, bool flag)
+  : BasicVariable<T>{ operation, flag }
 {
-  return *m_memory + *rscalar.m_memory;
+  this->m_memory = std::make_unique<T>(value);
 }
 
-double Scalar::subtract(const Scalar& subtrahend) const
+template <typename T>
+T BasicScalar<T>::add(const BasicScalar& rscalar) const
 {
-  return *m_memory - *subtrahend.m_memory;
+  return *this->m_memory + *rscalar.m_memory;
 }
 
-double Scalar::multiply(const Scalar& factor) const
+template <typename T>
+T BasicScalar<T>::subtract(const BasicScalar& subtrahend) const
 {
-  return (*m_memory) * (*factor.m_memory);
+  return *this->m_memory - *subtrahend.m_memory;
 }
 
-double Scalar::divide(const Scalar& denominator) const
+template <typename T>
+T BasicScalar<T>::multiply(const BasicScalar& factor) const
 {
-  return *m_memory / *denominator.m_memory;
+  return (*this->m_memory) * (*factor.m_memory);
 }
 
-std::ostream& Scalar::print(std::ostream& out) const
+template <typename T>
+T BasicScalar<T>::divide(const BasicScalar& denominator) const
+{
+  return *this->m_memory / *denominator.m_memory;
+}
+
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalar<T>::clone() const
+{
+  return std::make_unique<BasicScalar<T>>(*this);
+}
+
+template <typename T>
+std::ostream& BasicScalar<T>::print(std::ostream& out) const
 {
   auto& name{this->getName()};
   if (name != "")
     {
-      out << this->getName() << '=' << *m_memory;
+      out << this->getName() << '=' << *this->m_memory;
     }
   else
     {
-      out << *m_memory;
+      out << *this->m_memory;
     }
   return out;
 }
+
+template class BasicScalar<float>;
+template class BasicScalar<double>;
+template class BasicScalar<long double>;
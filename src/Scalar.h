@@ -11,32 +11,48 @@
 #include <memory>
 #include <string>
 
-class Scalar : public Variable
+template <typename T>
+class BasicScalar : public BasicVariable<T>
 {
 private:
   static constexpr int m_dimension{ 0 };
-  
+
 public:
-  Scalar(const std::string& name, const Operation& operation=input, // Specific name => Input
-	 double value=0.0, bool flag=false);
-  Scalar(const Operation& operation, double value=0.0, bool flag=false);
-  
+  BasicScalar(const std::string& name,
+	      const BasicOperation<T>& operation=basicInput<T>, // Specific name => Input
+	      T value=T{}, bool flag=false);
+  /** @brief A scalar with an interned or anonymous name, see SymbolTable. */
+  BasicScalar(SymbolTable::Symbol symbol, const BasicOperation<T>& operation, T value=T{},
+	      bool flag=false);
+  BasicScalar(const BasicOperation<T>& operation, T value=T{}, bool flag=false);
+
   constexpr int getDimension() const { return m_dimension; };
 
   // Kind of depreciated...
-  double add(const Scalar& rscalar) const;
-  double subtract(const Scalar& subtrahend) const;
-  double multiply(const Scalar& factor) const;
-  double divide(const Scalar& denominator) const;
+  T add(const BasicScalar& rscalar) const;
+  T subtract(const BasicScalar& subtrahend) const;
+  T multiply(const BasicScalar& factor) const;
+  T divide(const BasicScalar& denominator) const;
+
+  std::unique_ptr<BasicVariable<T>> clone() const override;
 
   std::ostream& print(std::ostream& out) const override;
 
-  static inline double value(const Variable& var)
+  static inline T value(const BasicVariable<T>& var)
   { return *var.getMemoryPtr(); }
 
-  static inline void setValue(Variable& var, double value)
-  { *var.getMemoryPtr() = value; }
+  /**
+   * @brief Sets the value from outside the graph. Its version only moves on a change.
+   */
+  static inline void setValue(BasicVariable<T>& var, T value)
+  {
+    if (BasicVariable<T>::sameValue(*var.getMemoryPtr(), value))
+      return;
+    *var.getMemoryPtr() = value;
+    var.markChanged();
+  }
 };
 
-#endif
+using Scalar = BasicScalar<double>;
 
+#endif
@@ -4,35 +4,65 @@
 #include <cassert>
 #include <cmath>
 
-using Gradient = std::vector<double>;
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarAbs<T>::operator()(const BasicVariable<T>& input) const
+{ return std::make_unique<BasicScalar<T>>(*this, std::abs( BasicScalar<T>::value(input) ) ); }
 
-std::unique_ptr<Variable> ScalarAbs::operator()(const Variable& input) const
-{ return std::make_unique<Scalar>(*this, std::abs( Scalar::value(input) ) ); }
-
-std::unique_ptr<Variable> ScalarAbs::operator()(DirectedGraph<Variable*>& graph, Variable& input) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarAbs<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& input) const
 {
-  auto res{ ScalarAbs::operator()(input) };
+  auto res{ BasicScalarAbs<T>::operator()(input) };
   graph.addConnection(&input, res.get());
   return res;
 }
 
-void ScalarAbs::uop(const Variable& input, Variable& variable) const 
+template <typename T>
+void BasicScalarAbs<T>::uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const
 {
   assert(isScalar(input) && isScalar(variable));
-    
-  *(variable.getMemoryPtr()) = std::abs(Scalar::value(input));
+
+  *(variable.getMemoryPtr()) = std::abs(BasicScalar<T>::value(input));
 }
 
-Gradient ScalarAbs::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-	       const Gradient& gradient) const 
+template <typename T>
+BasicGradient<T> BasicScalarAbs<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarUnaryBprop(inputs, diff_var, gradient);
 
-  return Gradient{ ( (Scalar::value(diff_var) >= 0.0) ? 1. : -1. ) * gradient[0] };
+  return BasicGradient<T>{ ( (BasicScalar<T>::value(diff_var) >= T{0}) ? T{1} : T{-1} ) * gradient[0] };
 }
 
-std::ostream& ScalarAbs::print(std::ostream& out) const 
+template <typename T>
+OpCode BasicScalarAbs<T>::getOpCode() const
+{ return OpCode::ScalarAbs; }
+
+template <typename T>
+T BasicScalarAbs<T>::eval(std::span<const T> args) const
+{ return std::abs(args[0]); }
+
+template <typename T>
+T BasicScalarAbs<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return (args[0] >= T{0}) ? T{1} : T{-1};
+}
+
+template <typename T>
+void BasicScalarAbs<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  adjoints[0] += (args[0] >= T{0}) ? gradient : -gradient;
+}
+
+template <typename T>
+std::ostream& BasicScalarAbs<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarAbs<float>;
+template class BasicScalarAbs<double>;
+template class BasicScalarAbs<long double>;
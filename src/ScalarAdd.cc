@@ -6,48 +6,82 @@
 #include <iostream>
 
 
-using Gradient = std::vector<double>;
-
-
-std::unique_ptr<Variable> ScalarAdd::operator()(const Variable& input1, const Variable& input2) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarAdd<T>::operator()(const BasicVariable<T>& input1,
+								const BasicVariable<T>& input2) const
 {
-  return std::make_unique<Scalar>(*this, Scalar::value(input1) + Scalar::value(input2));
+  return std::make_unique<BasicScalar<T>>(*this, BasicScalar<T>::value(input1)
+					  + BasicScalar<T>::value(input2));
 }
 
-std::unique_ptr<Variable> ScalarAdd::operator()(DirectedGraph<Variable*>& graph,
-					      Variable& input1, Variable& input2) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarAdd<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& input1,
+								BasicVariable<T>& input2) const
 {
   // Create the resulting scalar on the heap.
-  auto res{ std::make_unique<Scalar>(*this, Scalar::value(input1) + Scalar::value(input2)) };
+  auto res{ BasicScalarAdd<T>::operator()(input1, input2) };
 
   // Add connections to the graph
   graph.addConnection(&input1, res.get());
   graph.addConnection(&input2, res.get());
-    
+
   return res;
 }
-  
-void ScalarAdd::bop(const Variable& input1, const Variable& input2, Variable& variable) const
+
+template <typename T>
+void BasicScalarAdd<T>::bop(const BasicVariable<T>& input1, const BasicVariable<T>& input2,
+			    BasicVariable<T>& variable) const
 {
   assert(isScalar(input1) && isScalar(input2) && isScalar(variable));
-  
-  double value1{ Scalar::value(input1) };
-  double value2{ Scalar::value(input2) };
+
+  T value1{ BasicScalar<T>::value(input1) };
+  T value2{ BasicScalar<T>::value(input2) };
   *variable.getMemoryPtr() = value1 + value2;
 }
-  
-Gradient ScalarAdd::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			  const Gradient& gradient) const
+
+template <typename T>
+BasicGradient<T> BasicScalarAdd<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarBinaryBprop(inputs, diff_var, gradient);
 
   // The gradient of a + b = y w.r.t. a or b is always 1.0.
-  return Gradient{ 1.0 * gradient[0] };
+  return BasicGradient<T>{ gradient[0] };
+}
+
+
+template <typename T>
+OpCode BasicScalarAdd<T>::getOpCode() const
+{ return OpCode::ScalarAdd; }
+
+template <typename T>
+T BasicScalarAdd<T>::eval(std::span<const T> args) const
+{ return args[0] + args[1]; }
+
+template <typename T>
+T BasicScalarAdd<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  // The derivative of a + b is 1.0 w.r.t. both.
+  return T{1};
 }
 
-  
-std::ostream& ScalarAdd::print(std::ostream& out) const
+template <typename T>
+void BasicScalarAdd<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  adjoints[0] += gradient;
+  adjoints[1] += gradient;
+}
+
+template <typename T>
+std::ostream& BasicScalarAdd<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarAdd<float>;
+template class BasicScalarAdd<double>;
+template class BasicScalarAdd<long double>;
@@ -6,56 +6,93 @@
 #include <iostream>
 
 
-using Gradient = std::vector<double>;
-
-std::unique_ptr<Variable> ScalarDiv::operator()(const Variable& dividend,
-					      const Variable& divisor) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarDiv<T>::operator()(const BasicVariable<T>& dividend,
+								const BasicVariable<T>& divisor) const
 {
-  return std::make_unique<Scalar>(*this, Scalar::value(dividend) / Scalar::value(divisor) );
+  return std::make_unique<BasicScalar<T>>(*this, BasicScalar<T>::value(dividend)
+					  / BasicScalar<T>::value(divisor) );
 }
 
-std::unique_ptr<Variable> ScalarDiv::operator()(DirectedGraph<Variable*>& graph, Variable& dividend, Variable& divisor) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarDiv<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& dividend,
+								BasicVariable<T>& divisor) const
 {
   // Create the resulting scalar on the heap.
-  auto res{ std::make_unique<Scalar>(*this, Scalar::value(dividend) / Scalar::value(divisor) ) };
+  auto res{ BasicScalarDiv<T>::operator()(dividend, divisor) };
 
   // Add connections to the graph
   graph.addConnection(&dividend, res.get());
   graph.addConnection(&divisor, res.get());
 
   // We need to ensure that these are inside the inputs as intputs = {dividend, divisor}
-  assert(   *res->getInputs(graph).at(0) == dividend
-	 && *res->getInputs(graph).at(1) == divisor);
+  assert(   res->getInputs(graph).at(0) == &dividend
+	 && res->getInputs(graph).at(1) == &divisor);
   return res;
 }
 
-void ScalarDiv::bop(const Variable& dividend, const Variable& divisor, Variable& variable) const
+template <typename T>
+void BasicScalarDiv<T>::bop(const BasicVariable<T>& dividend, const BasicVariable<T>& divisor,
+			    BasicVariable<T>& variable) const
 {
 
   assert(isScalar(dividend) && isScalar(divisor) && isScalar(variable));
-  
-  double value1{ *dividend.getMemoryPtr() };
-  double value2{ *divisor.getMemoryPtr() };
+
+  T value1{ *dividend.getMemoryPtr() };
+  T value2{ *divisor.getMemoryPtr() };
   *variable.getMemoryPtr() = value1 / value2;
 }
 
-Gradient ScalarDiv::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			  const Gradient& gradient) const
-{  
+template <typename T>
+BasicGradient<T> BasicScalarDiv<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
+{
   validateScalarBinaryBprop(inputs, diff_var, gradient);
 
   // x/y
-  double x{ Scalar::value(*inputs[0]) };
-  double y{ Scalar::value(*inputs[1]) };
-  
+  T x{ BasicScalar<T>::value(*inputs[0]) };
+  T y{ BasicScalar<T>::value(*inputs[1]) };
+
   if (inputs.at(0) == &diff_var)
-    return Gradient{ 1.0/y * gradient[0] };
+    return BasicGradient<T>{ T{1}/y * gradient[0] };
   else
-    return Gradient{ -x/(y*y) * gradient[0] };
+    return BasicGradient<T>{ -x/(y*y) * gradient[0] };
 }
 
-std::ostream& ScalarDiv::print(std::ostream& out) const
+template <typename T>
+OpCode BasicScalarDiv<T>::getOpCode() const
+{ return OpCode::ScalarDiv; }
+
+template <typename T>
+T BasicScalarDiv<T>::eval(std::span<const T> args) const
+{ return args[0] / args[1]; }
+
+template <typename T>
+T BasicScalarDiv<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return (index == 0) ? T{1}/args[1] : -args[0]/(args[1]*args[1]);
+}
+
+template <typename T>
+void BasicScalarDiv<T>::bprop(std::span<const T> args, T output, T gradient,
+			    std::span<T> adjoints) const
+{
+  // Both partials share gradient/y.
+  const T quotient{ gradient / args[1] };
+  adjoints[0] += quotient;
+  // x/y^2 is the output divided by y once more.
+  adjoints[1] -= quotient * output;
+}
+
+template <typename T>
+std::ostream& BasicScalarDiv<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarDiv<float>;
+template class BasicScalarDiv<double>;
+template class BasicScalarDiv<long double>;
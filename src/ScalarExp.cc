@@ -4,35 +4,66 @@
 #include <cassert>
 #include <cmath>
 
-using Gradient = std::vector<double>;
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarExp<T>::operator()(const BasicVariable<T>& input) const
+{ return std::make_unique<BasicScalar<T>>(*this, std::exp( BasicScalar<T>::value(input) ) ); }
 
-std::unique_ptr<Variable> ScalarExp::operator()(const Variable& input) const
-{ return std::make_unique<Scalar>(*this, std::exp( Scalar::value(input) ) ); }
-
-std::unique_ptr<Variable> ScalarExp::operator()(DirectedGraph<Variable*>& graph, Variable& input) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarExp<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& input) const
 {
-  auto res{ ScalarExp::operator()(input) };
+  auto res{ BasicScalarExp<T>::operator()(input) };
   graph.addConnection(&input, res.get());
   return res;
 }
 
-void ScalarExp::uop(const Variable& input, Variable& variable) const 
+template <typename T>
+void BasicScalarExp<T>::uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const
 {
   assert(isScalar(input) && isScalar(variable));
-    
-  *(variable.getMemoryPtr()) = std::exp(Scalar::value(input));
+
+  *(variable.getMemoryPtr()) = std::exp(BasicScalar<T>::value(input));
 }
 
-Gradient ScalarExp::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-	       const Gradient& gradient) const 
+template <typename T>
+BasicGradient<T> BasicScalarExp<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarUnaryBprop(inputs, diff_var, gradient);
 
-  return Gradient{ std::exp(Scalar::value(diff_var)) * gradient[0] };
+  return BasicGradient<T>{ std::exp(BasicScalar<T>::value(diff_var)) * gradient[0] };
 }
 
-std::ostream& ScalarExp::print(std::ostream& out) const 
+template <typename T>
+OpCode BasicScalarExp<T>::getOpCode() const
+{ return OpCode::ScalarExp; }
+
+template <typename T>
+T BasicScalarExp<T>::eval(std::span<const T> args) const
+{ return std::exp(args[0]); }
+
+template <typename T>
+T BasicScalarExp<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return std::exp(args[0]);
+}
+
+template <typename T>
+void BasicScalarExp<T>::bprop(std::span<const T> args, T output, T gradient,
+			    std::span<T> adjoints) const
+{
+  // d/dx exp(x) is exp(x) itself.
+  adjoints[0] += gradient * output;
+}
+
+template <typename T>
+std::ostream& BasicScalarExp<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarExp<float>;
+template class BasicScalarExp<double>;
+template class BasicScalarExp<long double>;
@@ -7,24 +7,24 @@
 #include "DirectedGraph.h"
 
 #include <memory>
+#include <span>
 #include <string_view>
 #include <iostream>
 #include <vector>
 
-using Gradient = std::vector<double>;
-
-class ScalarExp final : public OperationUnary
+template <typename T>
+class BasicScalarExp final : public BasicOperationUnary<T>
 {
 private:
   static constexpr std::string_view m_name{"ScalarExp"};
-   
+
 public:
   /**
    * @brief Operator for the functor
    * @param input
    * @return Unique ptr to resulting scalar.
    */
-  std::unique_ptr<Variable> operator()(const Variable& input) const;
+  std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& input) const;
 
   /**
    * @brief Operator for the functor which takes a graph.
@@ -33,14 +33,25 @@ public:
    * @return Unique ptr to resulting scalar.
    * @note A raw ptr is also added to the graph.
    */
-  std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph, Variable& input) const;
-  void uop(const Variable& input, Variable& variable) const override;
+  std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+					       BasicVariable<T>& input) const;
+  void uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const override;
+
+  BasicGradient<T> bprop(const std::vector<BasicVariable<T>*>& inputs,
+			 const BasicVariable<T>& diff_var,
+			 const BasicGradient<T>& gradient) const override;
+
+  OpCode getOpCode() const override;
+
+  T eval(std::span<const T> args) const override;
+
+  T partial(std::span<const T> args, std::size_t index) const override;
+
+  void bprop(std::span<const T> args, T output, T gradient, std::span<T> adjoints) const override;
 
-  Gradient bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-		 const Gradient& gradient) const override;
-  
   std::ostream& print(std::ostream& out) const override;
 };
 
+using ScalarExp = BasicScalarExp<double>;
 
 #endif
@@ -4,36 +4,65 @@
 #include <cassert>
 #include <cmath>
 
-using Gradient = std::vector<double>;
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarLog<T>::operator()(const BasicVariable<T>& input) const
+{ return std::make_unique<BasicScalar<T>>(*this, std::log( BasicScalar<T>::value(input) ) ); }
 
-std::unique_ptr<Variable> ScalarLog::operator()(const Variable& input) const
-{ return std::make_unique<Scalar>(*this, std::log( Scalar::value(input) ) ); }
-
-std::unique_ptr<Variable> ScalarLog::operator()(DirectedGraph<Variable*>& graph,
-					      Variable& input) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarLog<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& input) const
 {
-  auto res{ ScalarLog::operator()(input) };
+  auto res{ BasicScalarLog<T>::operator()(input) };
   graph.addConnection(&input, res.get());
   return res;
 }
 
-void ScalarLog::uop(const Variable& input, Variable& variable) const
+template <typename T>
+void BasicScalarLog<T>::uop(const BasicVariable<T>& input, BasicVariable<T>& variable) const
 {
   assert(isScalar(input) && isScalar(variable));
-    
-  *(variable.getMemoryPtr()) = std::log(Scalar::value(input));
+
+  *(variable.getMemoryPtr()) = std::log(BasicScalar<T>::value(input));
 }
 
-Gradient ScalarLog::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			  const Gradient& gradient) const
+template <typename T>
+BasicGradient<T> BasicScalarLog<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarUnaryBprop(inputs, diff_var, gradient);
 
-  return Gradient{ 1.0/Scalar::value(diff_var) * gradient[0] };
+  return BasicGradient<T>{ T{1}/BasicScalar<T>::value(diff_var) * gradient[0] };
 }
 
-std::ostream& ScalarLog::print(std::ostream& out) const
+template <typename T>
+OpCode BasicScalarLog<T>::getOpCode() const
+{ return OpCode::ScalarLog; }
+
+template <typename T>
+T BasicScalarLog<T>::eval(std::span<const T> args) const
+{ return std::log(args[0]); }
+
+template <typename T>
+T BasicScalarLog<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return T{1}/args[0];
+}
+
+template <typename T>
+void BasicScalarLog<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  adjoints[0] += gradient / args[0];
+}
+
+template <typename T>
+std::ostream& BasicScalarLog<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarLog<float>;
+template class BasicScalarLog<double>;
+template class BasicScalarLog<long double>;
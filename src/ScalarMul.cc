@@ -6,48 +6,83 @@
 #include <iostream>
 
 
-using Gradient = std::vector<double>;
-
-
-std::unique_ptr<Variable> ScalarMul::operator()(const Variable& input1, const Variable& input2) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarMul<T>::operator()(const BasicVariable<T>& input1,
+								const BasicVariable<T>& input2) const
 {
-  return std::make_unique<Scalar>(*this, Scalar::value(input1) * Scalar::value(input2));
+  return std::make_unique<BasicScalar<T>>(*this, BasicScalar<T>::value(input1)
+					  * BasicScalar<T>::value(input2));
 }
 
-std::unique_ptr<Variable> ScalarMul::operator()(DirectedGraph<Variable*>& graph, Variable& input1, Variable& input2) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarMul<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& input1,
+								BasicVariable<T>& input2) const
 {
   // Create the resulting scalar on the heap.
-  auto res{ std::make_unique<Scalar>(*this, Scalar::value(input1) * Scalar::value(input2)) };
+  auto res{ BasicScalarMul<T>::operator()(input1, input2) };
 
   // Add connections to the graph
   graph.addConnection(&input1, res.get());
   graph.addConnection(&input2, res.get());
-    
+
   return res;
 }
-  
-void ScalarMul::bop(const Variable& input1, const Variable& input2, Variable& variable) const
+
+template <typename T>
+void BasicScalarMul<T>::bop(const BasicVariable<T>& input1, const BasicVariable<T>& input2,
+			    BasicVariable<T>& variable) const
 {
   assert(isScalar(input1) && isScalar(input2) && isScalar(variable));
-  
-  double value1{ Scalar::value(input1) };
-  double value2{ Scalar::value(input2) };
+
+  T value1{ BasicScalar<T>::value(input1) };
+  T value2{ BasicScalar<T>::value(input2) };
   *variable.getMemoryPtr() = value1 * value2;
 }
-  
-Gradient ScalarMul::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			  const Gradient& gradient) const
+
+template <typename T>
+BasicGradient<T> BasicScalarMul<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarBinaryBprop(inputs, diff_var, gradient);
 
   // a * b -> b if deriving var is a
-  return Gradient{ gradient[0] * ( (inputs.at(0) == &diff_var) ?
-				   Scalar::value(*inputs.at(1)) : Scalar::value(*inputs.at(0)) ) }; 
+  return BasicGradient<T>{ gradient[0] * ( (inputs.at(0) == &diff_var) ?
+					   BasicScalar<T>::value(*inputs.at(1))
+					   : BasicScalar<T>::value(*inputs.at(0)) ) };
+}
+
+
+template <typename T>
+OpCode BasicScalarMul<T>::getOpCode() const
+{ return OpCode::ScalarMul; }
+
+template <typename T>
+T BasicScalarMul<T>::eval(std::span<const T> args) const
+{ return args[0] * args[1]; }
+
+template <typename T>
+T BasicScalarMul<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return args[1 - index];
 }
 
-  
-std::ostream& ScalarMul::print(std::ostream& out) const
+template <typename T>
+void BasicScalarMul<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  adjoints[0] += gradient * args[1];
+  adjoints[1] += gradient * args[0];
+}
+
+template <typename T>
+std::ostream& BasicScalarMul<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarMul<float>;
+template class BasicScalarMul<double>;
+template class BasicScalarMul<long double>;
@@ -7,17 +7,17 @@
 #include "DirectedGraph.h"
 
 #include <memory>
+#include <span>
 #include <string_view>
 #include <iostream>
 
-using Gradient = std::vector<double>;
 
-
-class ScalarMul final : public OperationBinary
+template <typename T>
+class BasicScalarMul final : public BasicOperationBinary<T>
 {
 private:
   static constexpr std::string_view m_name{"ScalarMul"};
-  
+
 public:
   /**
    * @brief Operator for the functor
@@ -25,7 +25,8 @@ public:
    * @param input2
    * @return Unique ptr to resulting scalar.
    */
-  std::unique_ptr<Variable> operator()(const Variable& input1, const Variable& input2) const;
+  std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& input1,
+					       const BasicVariable<T>& input2) const;
 
   /**
    * @brief Operator for the functor which takes a graph.
@@ -35,16 +36,28 @@ public:
    * @return Unique ptr to resulting scalar.
    * @note A raw ptr is also added to the graph.
    */
-  std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph,
-				     Variable& input1, Variable& input2) const;
-  
-  void bop(const Variable& input1, const Variable& input2, Variable& variable) const override;
-
-  Gradient bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-		 const Gradient& gradient) const override;
-  
+  std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+					       BasicVariable<T>& input1,
+					       BasicVariable<T>& input2) const;
+
+  void bop(const BasicVariable<T>& input1, const BasicVariable<T>& input2,
+	   BasicVariable<T>& variable) const override;
+
+  BasicGradient<T> bprop(const std::vector<BasicVariable<T>*>& inputs,
+			 const BasicVariable<T>& diff_var,
+			 const BasicGradient<T>& gradient) const override;
+
+  OpCode getOpCode() const override;
+
+  T eval(std::span<const T> args) const override;
+
+  T partial(std::span<const T> args, std::size_t index) const override;
+
+  void bprop(std::span<const T> args, T output, T gradient, std::span<T> adjoints) const override;
+
   std::ostream& print(std::ostream& out) const override;
 };
 
+using ScalarMul = BasicScalarMul<double>;
 
 #endif
@@ -6,53 +6,86 @@
 #include <iostream>
 
 
-using Gradient = std::vector<double>;
-
-std::unique_ptr<Variable> ScalarSub::operator()(const Variable& minuend,
-					      const Variable& subtrahend) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarSub<T>::operator()(const BasicVariable<T>& minuend,
+								const BasicVariable<T>& subtrahend) const
 {
-  return std::make_unique<Scalar>(*this, Scalar::value(minuend) - Scalar::value(subtrahend));
+  return std::make_unique<BasicScalar<T>>(*this, BasicScalar<T>::value(minuend)
+					  - BasicScalar<T>::value(subtrahend));
 }
 
-std::unique_ptr<Variable> ScalarSub::operator()(DirectedGraph<Variable*>& graph,
-					      Variable& minuend, Variable& subtrahend) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarSub<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& minuend,
+								BasicVariable<T>& subtrahend) const
 {
   // Create the resulting scalar on the heap.
-  auto res{ std::make_unique<Scalar>(*this, Scalar::value(minuend) - Scalar::value(subtrahend)) };
+  auto res{ BasicScalarSub<T>::operator()(minuend, subtrahend) };
 
   // Add connections to the graph
   graph.addConnection(&minuend, res.get());
   graph.addConnection(&subtrahend, res.get());
 
   // We need to ensure that these are inside the inputs as intputs = {minuend, subtrahend}
-  assert(   *res->getInputs(graph).at(0) == minuend
-	 && *res->getInputs(graph).at(1) == subtrahend);
+  assert(   res->getInputs(graph).at(0) == &minuend
+	 && res->getInputs(graph).at(1) == &subtrahend);
   return res;
 }
 
-void ScalarSub::bop(const Variable& minuend, const Variable& subtrahend, Variable& variable) const
+template <typename T>
+void BasicScalarSub<T>::bop(const BasicVariable<T>& minuend, const BasicVariable<T>& subtrahend,
+			    BasicVariable<T>& variable) const
 {
 
   assert(isScalar(minuend) && isScalar(subtrahend) && isScalar(variable));
-  
-  double value1{ *minuend.getMemoryPtr() };
-  double value2{ *subtrahend.getMemoryPtr() };
+
+  T value1{ *minuend.getMemoryPtr() };
+  T value2{ *subtrahend.getMemoryPtr() };
   *variable.getMemoryPtr() = value1 - value2;
 }
 
-Gradient ScalarSub::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			  const Gradient& gradient) const
-{  
+template <typename T>
+BasicGradient<T> BasicScalarSub<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
+{
   validateScalarBinaryBprop(inputs, diff_var, gradient);
-  // The gradient of a + b = y w.r.t. a or b is always 1.0.
+  // The gradient of a - b = y w.r.t. a is 1.0 and w.r.t. b is -1.0.
   if (inputs.at(0) == &diff_var)
-    return Gradient{ 1.0 * gradient[0] };
+    return BasicGradient<T>{ gradient[0] };
   else
-    return Gradient{ -1.0 * gradient[0] };
+    return BasicGradient<T>{ -gradient[0] };
+}
+
+template <typename T>
+OpCode BasicScalarSub<T>::getOpCode() const
+{ return OpCode::ScalarSub; }
+
+template <typename T>
+T BasicScalarSub<T>::eval(std::span<const T> args) const
+{ return args[0] - args[1]; }
+
+template <typename T>
+T BasicScalarSub<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return (index == 0) ? T{1} : T{-1};
+}
+
+template <typename T>
+void BasicScalarSub<T>::bprop(std::span<const T> args, T /*output*/, T gradient,
+			    std::span<T> adjoints) const
+{
+  adjoints[0] += gradient;
+  adjoints[1] -= gradient;
 }
 
-std::ostream& ScalarSub::print(std::ostream& out) const
+template <typename T>
+std::ostream& BasicScalarSub<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarSub<float>;
+template class BasicScalarSub<double>;
+template class BasicScalarSub<long double>;
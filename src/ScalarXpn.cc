@@ -6,58 +6,93 @@
 #include <iostream>
 #include <cmath>
 
-using Gradient = std::vector<double>;
 
-
-std::unique_ptr<Variable> ScalarXpn::operator()(const Variable& base, const Variable& exponent) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarXpn<T>::operator()(const BasicVariable<T>& base,
+								const BasicVariable<T>& exponent) const
 {
-  return std::make_unique<Scalar>(*this, std::pow(Scalar::value(base), Scalar::value(exponent)) );
+  return std::make_unique<BasicScalar<T>>(*this, std::pow(BasicScalar<T>::value(base),
+							  BasicScalar<T>::value(exponent)) );
 }
 
-std::unique_ptr<Variable> ScalarXpn::operator()(DirectedGraph<Variable*>& graph,
-					      Variable& base, Variable& exponent) const
+template <typename T>
+std::unique_ptr<BasicVariable<T>> BasicScalarXpn<T>::operator()(DirectedGraph<BasicVariable<T>*>& graph,
+								BasicVariable<T>& base,
+								BasicVariable<T>& exponent) const
 {
   // Create the resulting scalar on the heap.
-  auto res{ ScalarXpn::operator()(base, exponent) };
+  auto res{ BasicScalarXpn<T>::operator()(base, exponent) };
 
   // Xpn connections to the graph
   graph.addConnection(&base, res.get());
   graph.addConnection(&exponent, res.get());
-    
+
   return res;
 }
-  
-void ScalarXpn::bop(const Variable& base, const Variable& exponent, Variable& variable) const
+
+template <typename T>
+void BasicScalarXpn<T>::bop(const BasicVariable<T>& base, const BasicVariable<T>& exponent,
+			    BasicVariable<T>& variable) const
 {
   assert(isScalar(base) && isScalar(exponent) && isScalar(variable));
-  
-  *variable.getMemoryPtr() = std::pow(Scalar::value(base), Scalar::value(exponent));
+
+  *variable.getMemoryPtr() = std::pow(BasicScalar<T>::value(base), BasicScalar<T>::value(exponent));
 }
-  
-Gradient ScalarXpn::bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-			   const Gradient& gradient) const
+
+template <typename T>
+BasicGradient<T> BasicScalarXpn<T>::bprop(const std::vector<BasicVariable<T>*>& inputs,
+					  const BasicVariable<T>& diff_var,
+					  const BasicGradient<T>& gradient) const
 {
   validateScalarBinaryBprop(inputs, diff_var, gradient);
 
+  const T base{ BasicScalar<T>::value(*inputs[0]) };
+  const T exponent{ BasicScalar<T>::value(*inputs[1]) };
   if (&diff_var == inputs[0])
     {
-      return Gradient{    Scalar::value(*inputs[1])
-			* std::pow(Scalar::value(*inputs[0]), Scalar::value(*inputs[1]) - 1.0)
-			* gradient[0]
-		     };
+      return BasicGradient<T>{ exponent * std::pow(base, exponent - T{1}) * gradient[0] };
     }
   else
     {
-      return Gradient{    std::log(Scalar::value(*inputs[0]))
-			* std::pow(Scalar::value(*inputs[0]), Scalar::value(*inputs[1]) )
-			* gradient[0]
-		     };
+      return BasicGradient<T>{ std::log(base) * std::pow(base, exponent) * gradient[0] };
     }
 }
 
-  
-std::ostream& ScalarXpn::print(std::ostream& out) const
+
+template <typename T>
+OpCode BasicScalarXpn<T>::getOpCode() const
+{ return OpCode::ScalarXpn; }
+
+template <typename T>
+T BasicScalarXpn<T>::eval(std::span<const T> args) const
+{ return std::pow(args[0], args[1]); }
+
+template <typename T>
+T BasicScalarXpn<T>::partial(std::span<const T> args, std::size_t index) const
+{
+  return (index == 0) ? args[1] * std::pow(args[0], args[1] - T{1})
+		      : std::log(args[0]) * std::pow(args[0], args[1]);
+}
+
+template <typename T>
+void BasicScalarXpn<T>::bprop(std::span<const T> args, T output, T gradient,
+			    std::span<T> adjoints) const
+{
+  // x^(y-1) is x^y/x, unless x^y under- or overflowed, i.e. for x = 0, where the quotient is
+  // undefined or off.
+  const T power{ (std::isnormal(output) && args[0] != T{0})
+		 ? output / args[0] : std::pow(args[0], args[1] - T{1}) };
+  adjoints[0] += gradient * args[1] * power;
+  adjoints[1] += gradient * std::log(args[0]) * output;
+}
+
+template <typename T>
+std::ostream& BasicScalarXpn<T>::print(std::ostream& out) const
 {
   out << m_name;
   return out;
 }
+
+template class BasicScalarXpn<float>;
+template class BasicScalarXpn<double>;
+template class BasicScalarXpn<long double>;
@@ -7,30 +7,43 @@
 #include "DirectedGraph.h"
 
 #include <memory>
+#include <span>
 #include <string_view>
 #include <iostream>
 
-using Gradient = std::vector<double>;
 
-
-class ScalarXpn final : public OperationBinary
+template <typename T>
+class BasicScalarXpn final : public BasicOperationBinary<T>
 {
 private:
   static constexpr std::string_view m_name{"ScalarXpn"};
-  
+
 public:
-  std::unique_ptr<Variable> operator()(const Variable& base, const Variable& exponent) const;
+  std::unique_ptr<BasicVariable<T>> operator()(const BasicVariable<T>& base,
+					       const BasicVariable<T>& exponent) const;
+
+  std::unique_ptr<BasicVariable<T>> operator()(DirectedGraph<BasicVariable<T>*>& graph,
+					       BasicVariable<T>& base,
+					       BasicVariable<T>& exponent) const;
+
+  void bop(const BasicVariable<T>& base, const BasicVariable<T>& exponent,
+	   BasicVariable<T>& variable) const override;
+
+  BasicGradient<T> bprop(const std::vector<BasicVariable<T>*>& inputs,
+			 const BasicVariable<T>& diff_var,
+			 const BasicGradient<T>& gradient) const override;
+
+  OpCode getOpCode() const override;
+
+  T eval(std::span<const T> args) const override;
+
+  T partial(std::span<const T> args, std::size_t index) const override;
 
-  std::unique_ptr<Variable> operator()(DirectedGraph<Variable*>& graph,
-				     Variable& base, Variable& exponent) const;
-  
-  void bop(const Variable& base, const Variable& exponent, Variable& variable) const override;
+  void bprop(std::span<const T> args, T output, T gradient, std::span<T> adjoints) const override;
 
-  Gradient bprop(const std::vector<Variable*>& inputs, const Variable& diff_var,
-		 const Gradient& gradient) const override;
-  
   std::ostream& print(std::ostream& out) const override;
 };
 
+using ScalarXpn = BasicScalarXpn<double>;
 
 #endif
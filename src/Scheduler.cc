@@ -0,0 +1,123 @@
+
+#include "Scheduler.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <optional>
+#include <exception>
+#include <algorithm>
+
+namespace
+{
+  /**
+   * @brief Queue of ready tasks owned by one thread. Only the owner pushes and pops at the
+   *        back, other threads steal from the front.
+   */
+  class WorkQueue
+  {
+  private:
+    std::mutex m_mutex{};
+    std::deque<std::size_t> m_tasks{};
+
+  public:
+    void push(std::size_t task)
+    {
+      std::lock_guard lock{ m_mutex };
+      m_tasks.push_back(task);
+    }
+    std::optional<std::size_t> pop()
+    {
+      std::lock_guard lock{ m_mutex };
+      if (m_tasks.empty())
+	return std::nullopt;
+      const std::size_t task{ m_tasks.back() };
+      m_tasks.pop_back();
+      return task;
+    }
+    std::optional<std::size_t> steal()
+    {
+      std::lock_guard lock{ m_mutex };
+      if (m_tasks.empty())
+	return std::nullopt;
+      const std::size_t task{ m_tasks.front() };
+      m_tasks.pop_front();
+      return task;
+    }
+  };
+}
+
+ThreadPool& ParallelOptions::getPool() const
+{
+  return pool ? *pool : ThreadPool::global();
+}
+
+std::size_t ParallelOptions::concurrency() const
+{
+  const std::size_t available{ getPool().size() };
+  return (threads == 0) ? available : std::min(threads, available);
+}
+
+void scheduleParallel(const DependencyGraph& dag, const ParallelOptions& options,
+		      const std::function<void(std::size_t)>& task)
+{
+  const std::size_t n{ dag.size() };
+  if (n == 0)
+    return;
+  const std::size_t threads{ std::clamp<std::size_t>(options.concurrency(), 1, n) };
+
+  std::vector<std::atomic<int>> remaining(n);
+  std::vector<WorkQueue> queues(threads);
+  for (std::size_t i{0}, next{0}; i < n; ++i)
+    {
+      remaining[i].store(dag.dependencies[i], std::memory_order_relaxed);
+      if (dag.dependencies[i] == 0)
+	queues[next++ % threads].push(i);   // Spread the initially ready tasks.
+    }
+
+  std::atomic<std::size_t> completed{ 0 };
+  std::atomic<bool> failed{ false };
+  std::exception_ptr error{};
+  std::mutex errorMutex{};
+
+  auto worker{ [&](std::size_t id) {
+    while (completed.load(std::memory_order_acquire) < n
+	   && !failed.load(std::memory_order_relaxed))
+      {
+	std::optional<std::size_t> current{ queues[id].pop() };
+	for (std::size_t k{1}; !current && k < threads; ++k)
+	  current = queues[(id + k) % threads].steal();
+	if (!current)
+	  {
+	    std::this_thread::yield();
+	    continue;
+	  }
+	try
+	  {
+	    task(*current);
+	  }
+	catch (...)
+	  {
+	    std::lock_guard lock{ errorMutex };
+	    if (!error)
+	      error = std::current_exception();
+	    failed.store(true);
+	    return;
+	  }
+	// The thread that finishes the last predecessor makes the successor ready. The
+	// acq_rel ordering makes the work of all predecessors visible to it.
+	for (std::size_t successor : dag.getSuccessors(*current))
+	  {
+	    if (remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+	      queues[id].push(successor);
+	  }
+	completed.fetch_add(1, std::memory_order_release);
+      }
+  }};
+
+  // Participants the pool could not provide leave their queue to be stolen.
+  options.getPool().run(threads, worker);
+  if (error)
+    std::rethrow_exception(error);
+}
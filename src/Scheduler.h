@@ -0,0 +1,70 @@
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <span>
+
+class ThreadPool;
+
+/**
+ * @brief A directed acyclic graph of tasks in compressed form. The successors of task i are
+ *        successors[successorOffsets[i]] to successors[successorOffsets[i+1]].
+ * @param dependencies The number of predecessors of each task, counting repeated edges.
+ */
+struct DependencyGraph
+{
+  std::vector<std::size_t> successorOffsets{ 0 };
+  std::vector<std::size_t> successors{};
+  std::vector<int> dependencies{};
+
+  std::size_t size() const { return dependencies.size(); }
+
+  std::span<const std::size_t> getSuccessors(std::size_t task) const
+  {
+    return { successors.data() + successorOffsets[task],
+	     successorOffsets[task + 1] - successorOffsets[task] };
+  }
+};
+
+/**
+ * @brief Options for the parallel engines.
+ * @param threads Number of threads, including the calling thread. 0 uses the whole pool.
+ * @param threshold Graphs with fewer tasks than this are run on the calling thread only,
+ *                  since the scheduling overhead would be larger than the work.
+ * @param deterministic Sums are always taken in the same order, so that results do not
+ *                      depend on how the threads were scheduled.
+ * @param pool The pool to run on, nullptr for ThreadPool::global().
+ */
+struct ParallelOptions
+{
+  std::size_t threads{ 0 };
+  std::size_t threshold{ 1024 };
+  bool deterministic{ false };
+  ThreadPool* pool{ nullptr };
+
+  /** @brief The pool that is used. */
+  ThreadPool& getPool() const;
+  /** @brief The number of threads that is used, at most the size of the pool. */
+  std::size_t concurrency() const;
+};
+
+/**
+ * Every task is run exactly once and only after all of its predecessors have finished. Each
+ * task has an atomic counter of unfinished predecessors and the thread finishing the last
+ * predecessor pushes it onto its own queue. Threads take work from the back of their own
+ * queue and steal from the front of the other queues when theirs is empty.
+ * @brief Runs a dependency graph of tasks with work stealing on a thread pool.
+ * @param dag The tasks and their dependencies.
+ * @param options The pool and the number of threads to use, including the calling thread.
+ * @param task Called with the index of each task. It may be called concurrently for tasks
+ *             that do not depend on each other. If it throws, the remaining tasks are
+ *             abandoned and the first exception is rethrown on the calling thread.
+ */
+void scheduleParallel(const DependencyGraph& dag, const ParallelOptions& options,
+		      const std::function<void(std::size_t)>& task);
+
+#endif
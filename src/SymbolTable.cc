@@ -0,0 +1,75 @@
+
+#include "SymbolTable.h"
+#include "Exceptions.h"
+
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <string_view>
+#include <shared_mutex>
+#include <mutex>
+
+namespace
+{
+  struct Table
+  {
+    std::shared_mutex mutex{};
+    std::deque<std::string> names{ std::string{} };   // A deque never moves its elements.
+    std::unordered_map<std::string_view, SymbolTable::Symbol> ids{ { names.front(), 0 } };
+  };
+
+  Table& table()
+  {
+    static Table s_table{};
+    return s_table;
+  }
+}
+
+SymbolTable::Symbol SymbolTable::intern(const std::string& name)
+{
+  Table& t{ table() };
+  {
+    std::shared_lock lock{ t.mutex };
+    const auto it{ t.ids.find(name) };
+    if (it != t.ids.end())
+      return it->second;
+  }
+  std::unique_lock lock{ t.mutex };
+  const auto it{ t.ids.find(name) };   // Another thread may have added it meanwhile.
+  if (it != t.ids.end())
+    return it->second;
+  const auto symbol{ static_cast<Symbol>(t.names.size()) };
+  if (isAnonymous(symbol))
+    throw InvalidOperationException("Too many interned names.");
+  t.names.push_back(name);
+  t.ids.emplace(t.names.back(), symbol);
+  return symbol;
+}
+
+SymbolTable::Symbol SymbolTable::anonymous()
+{
+  static std::atomic<Symbol> s_next{ firstAnonymous };
+  const Symbol symbol{ s_next.fetch_add(1, std::memory_order_relaxed) };
+  if (symbol < firstAnonymous)   // Wrapped around.
+    throw InvalidOperationException("Too many anonymous symbols.");
+  return symbol;
+}
+
+const std::string& SymbolTable::name(Symbol symbol)
+{
+  static const std::string s_anonymous{};
+  if (isAnonymous(symbol))
+    return s_anonymous;
+  Table& t{ table() };
+  std::shared_lock lock{ t.mutex };
+  if (symbol >= t.names.size())
+    throw InvalidOperationException("Unknown symbol.");
+  return t.names[symbol];
+}
+
+std::size_t SymbolTable::size()
+{
+  Table& t{ table() };
+  std::shared_lock lock{ t.mutex };
+  return t.names.size();
+}
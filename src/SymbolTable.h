@@ -0,0 +1,46 @@
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Variable names are stored once in a global table and variables only keep the id, so that
+ * names are compared and hashed as integers. Equal names always get the same id and the
+ * empty name has id 0. The table is thread-safe and only grows, so variables that are
+ * created in large numbers without a name of their own, i.e. the parameters of units, use
+ * anonymous ids instead. These come from a range of their own and never enter the table.
+ * @brief Global table of interned variable names.
+ */
+class SymbolTable
+{
+public:
+  using Symbol = std::uint32_t;
+
+  /** @brief The first anonymous id, interned names get smaller ids. */
+  static constexpr Symbol firstAnonymous{ 0x80000000u };
+
+  /** @brief The id of name, adding it to the table on first use. */
+  static Symbol intern(const std::string& name);
+
+  /**
+   * @brief A new id that is equal to no other, without a name in the table. Thread-safe.
+   */
+  static Symbol anonymous();
+
+  static bool isAnonymous(Symbol symbol)
+  { return symbol >= firstAnonymous; }
+
+  /**
+   * @brief The name of an interned id, empty for an anonymous one. The reference stays valid
+   *        for the whole program.
+   */
+  static const std::string& name(Symbol symbol);
+
+  /** @brief Number of interned names, the empty name included. */
+  static std::size_t size();
+};
+
+#endif
@@ -0,0 +1,135 @@
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+  std::mutex s_globalMutex{};
+  std::unique_ptr<ThreadPool> s_global{};
+}
+
+ThreadPool::ThreadPool(std::size_t threads, bool pinned)
+{
+  const std::size_t workers{ std::max<std::size_t>(threads, 1) - 1 };
+  m_workers.reserve(workers);
+  for (std::size_t id{0}; id < workers; ++id)
+    {
+      m_workers.emplace_back(&ThreadPool::workerLoop, this, id + 1);
+#ifdef __linux__
+      if (pinned)
+	{
+	  const unsigned cores{ std::max(1u, std::thread::hardware_concurrency()) };
+	  cpu_set_t set{};
+	  CPU_ZERO(&set);
+	  CPU_SET((id + 1) % cores, &set);
+	  pthread_setaffinity_np(m_workers.back().native_handle(), sizeof(set), &set);
+	}
+#else
+      (void)pinned;
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard lock{ m_mutex };
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+void ThreadPool::workerLoop(std::size_t id)
+{
+  t_inJob = true;   // Everything a worker runs is part of a job.
+  std::uint64_t seen{ 0 };
+  std::unique_lock lock{ m_mutex };
+  while (true)
+    {
+      m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+      if (m_stop)
+	return;
+      seen = m_generation;
+      if (id >= m_participants)
+	continue;   // Not needed for this job.
+      const auto* job{ m_job };
+      lock.unlock();
+      try
+	{
+	  (*job)(id);
+	}
+      catch (...)
+	{
+	  std::lock_guard errorLock{ m_mutex };
+	  if (!m_error)
+	    m_error = std::current_exception();
+	}
+      lock.lock();
+      if (--m_active == 0)
+	m_done.notify_all();
+    }
+}
+
+void ThreadPool::run(std::size_t participants, const std::function<void(std::size_t)>& body)
+{
+  participants = std::min(participants, size());
+  std::unique_lock submit{ m_submit, std::defer_lock };
+  if (participants <= 1 || t_inJob || !submit.try_lock())
+    {
+      body(0);
+      return;
+    }
+  {
+    std::lock_guard lock{ m_mutex };
+    m_job = &body;
+    m_participants = participants;
+    m_active = participants - 1;
+    m_error = nullptr;
+    ++m_generation;
+  }
+  m_wake.notify_all();
+
+  std::exception_ptr error{};
+  t_inJob = true;
+  try
+    {
+      body(0);
+    }
+  catch (...)
+    {
+      error = std::current_exception();
+    }
+  t_inJob = false;
+
+  std::unique_lock lock{ m_mutex };
+  m_done.wait(lock, [&] { return m_active == 0; });
+  m_job = nullptr;
+  if (!error)
+    error = m_error;
+  lock.unlock();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+ThreadPool& ThreadPool::global()
+{
+  std::lock_guard lock{ s_globalMutex };
+  if (!s_global)
+    s_global = std::make_unique<ThreadPool>();
+  return *s_global;
+}
+
+void ThreadPool::configure(std::size_t threads, bool pinned)
+{
+  std::lock_guard lock{ s_globalMutex };
+  s_global.reset();   // Joins the old workers first.
+  s_global = std::make_unique<ThreadPool>(threads, pinned);
+}
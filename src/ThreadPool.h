@@ -0,0 +1,81 @@
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Worker threads that live as long as the pool and are shared by all parallel engines, so
+ * that no engine spawns threads of its own. The pool runs one job at a time. A job that is
+ * submitted while another is running, or from inside a job, i.e. nested parallelism, runs
+ * on the calling thread alone instead of waiting, so the pool can never deadlock.
+ * @brief Persistent pool of worker threads.
+ */
+class ThreadPool
+{
+private:
+  std::vector<std::thread> m_workers{};
+  std::mutex m_submit{};          // Held while a job runs.
+  std::mutex m_mutex{};
+  std::condition_variable m_wake{};
+  std::condition_variable m_done{};
+  const std::function<void(std::size_t)>* m_job{ nullptr };
+  std::size_t m_participants{ 0 };
+  std::size_t m_active{ 0 };
+  std::uint64_t m_generation{ 0 };
+  bool m_stop{ false };
+  std::exception_ptr m_error{};
+
+  inline static thread_local bool t_inJob{ false };
+
+  void workerLoop(std::size_t id);
+
+public:
+  /**
+   * @param threads Number of threads including the thread that submits, so a pool of size
+   *                1 has no workers and runs everything on the calling thread.
+   * @param pinned Pins worker i to core i, on Linux only. The submitting thread is not pinned.
+   */
+  explicit ThreadPool(std::size_t threads=std::thread::hardware_concurrency(), bool pinned=false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /** @brief Number of threads including the thread that submits. */
+  std::size_t size() const
+  { return m_workers.size() + 1; }
+
+  /**
+   * Calls body(0) on the calling thread and body(1) to body(participants-1) on workers and
+   * returns when all calls have. Fewer calls are made when the pool is smaller, busy or when
+   * run is called from inside a job, so body must not rely on the other calls being made;
+   * the scheduler for example steals the work of participants that never started.
+   * @brief Runs a job on several threads of the pool.
+   * @param participants The wanted number of threads.
+   * @param body Called with the participant id. The first exception thrown is rethrown.
+   */
+  void run(std::size_t participants, const std::function<void(std::size_t)>& body);
+
+  /**
+   * @brief The pool used by the engines when no other pool is given. It is created on first
+   *        use with one thread per core.
+   */
+  static ThreadPool& global();
+
+  /**
+   * @brief Replaces the global pool, i.e. configure(1) runs the whole library on the calling
+   *        threads for deterministic tests. Must not be called while the pool runs a job.
+   */
+  static void configure(std::size_t threads, bool pinned=false);
+};
+
+#endif
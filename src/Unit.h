@@ -1,3 +1,7 @@
+
+#ifndef UNIT_H
+#define UNIT_H
+
 #include "Scalar.h"
 #include "Variable.h"
 #include "DirectedGraph.h"
@@ -7,184 +11,570 @@
 #include "util.h"
 #include "forwardProp.h"
 #include "backProp.h"
+#include "SymbolTable.h"
+#include "ExecutionPlan.h"
+#include "CompactGraph.h"
+#include "InferenceModel.h"
+#include "GraphFile.h"
+#include "MemoryUsage.h"
+#include "Profiler.h"
+#include "checks.h"
 
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <cstdint>
+#include <string>
 #include <utility>
+#include <span>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
 
 using uvptr = std::unique_ptr<Variable>;
-  
-class Unit
+
+/**
+ * @brief A function of any number of named inputs built from operations on Scalars of type T.
+ */
+template <typename T>
+class BasicUnit
 {
 private:
+  using Var = BasicVariable<T>;
+  using uvptr = std::unique_ptr<Var>;
+
   std::vector<uvptr> m_varsContainer{};
-  std::vector<Variable*> m_leafs{};
-  DirectedGraph<Variable*> m_graph{};
-  
-  void binaryOp(uvptr rightArg, const OperationBinary& operation) {
-    auto res{ operation(m_graph, getOutput(), *rightArg) };
-    m_leafs.push_back(rightArg.get());
+  std::vector<Var*> m_leafs{};
+  std::unordered_map<SymbolTable::Symbol, Var*> m_leafIndex{};   // The first leaf of each name.
+  std::vector<Var*> m_inputs{};   // The named leafs the unit is a function of, in order.
+  DirectedGraph<Var*> m_graph{};
+  std::vector<Var*> m_order{};    // Evaluation order of the output, empty when out of date.
+  bool m_cutoff{ true };
+  bool m_lazy{ false };
+  std::size_t m_recomputed{ 0 };
+
+  /* Recomputes the variables affected by changed inputs or parameters. The order is validated
+     once when it is built, the passes over it are unchecked. */
+  void update() {
+    if (m_order.empty()) {
+      m_order = m_graph.topologicalOrder({ &getOutput() });
+      for (Var* var : m_order)
+	validateNode(*var, var->getInputs(m_graph).size());
+    }
+    m_recomputed = forwardProp_incremental(m_graph, m_order, m_cutoff);
+  }
+
+  void addLeaf(Var* leaf) {
+    m_leafs.push_back(leaf);
+    m_leafIndex.try_emplace(leaf->getSymbol(), leaf);
+  }
+
+  /* Adds a variable for operation on the inputs. In lazy mode only the graph is built and the
+     variable is left dirty, the next update computes it. */
+  uvptr record(const BasicOperationBinary<T>& operation, Var& input1, Var& input2) {
+    if (!m_lazy)
+      return operation(m_graph, input1, input2);
+    uvptr res{ std::make_unique<BasicScalar<T>>(operation) };
+    m_graph.addConnection(&input1, res.get());
+    m_graph.addConnection(&input2, res.get());
+    return res;
+  }
+  uvptr record(const BasicOperationUnary<T>& operation, Var& input) {
+    if (!m_lazy)
+      return operation(m_graph, input);
+    uvptr res{ std::make_unique<BasicScalar<T>>(operation) };
+    m_graph.addConnection(&input, res.get());
+    return res;
+  }
+
+  void binaryOp(uvptr rightArg, const BasicOperationBinary<T>& operation) {
+    m_order.clear();
+    auto res{ record(operation, getOutput(), *rightArg) };
+    addLeaf(rightArg.get());
     m_varsContainer.push_back(std::move(rightArg));
     m_varsContainer.push_back(std::move(res));
   }
-  void binaryOp(double value, const OperationBinary& operation) {    
-    static int counter{0};
-    std::stringstream ss{};
-    ss << "prm-" << counter++; 
-    binaryOp(std::make_unique<Scalar>(ss.str(), input, value), operation);
+  /* Leafs are matched by name, so every parameter gets an anonymous one, equal to no other
+     leaf of the process and not kept by the symbol table. */
+  void binaryOp(T value, const BasicOperationBinary<T>& operation) {
+    binaryOp(std::make_unique<BasicScalar<T>>(SymbolTable::anonymous(), basicInput<T>, value),
+	     operation);
   }
-  void unaryOp(const OperationUnary& operation) {
-    auto res{ operation(m_graph, getOutput()) };
+  void unaryOp(const BasicOperationUnary<T>& operation) {
+    m_order.clear();
+    auto res{ record(operation, getOutput()) };
     m_varsContainer.push_back(std::move(res));
   }
 
   /* Performs a matched merge with o_unit. o_ubut will be left in an indeterminate state.*/
-  void matchedMerge(Unit& o_unit, const std::vector<std::pair<Variable*, Variable*>>& matches)
+  void matchedMerge(BasicUnit& o_unit, const std::vector<std::pair<Var*, Var*>>& matches)
   {
-    assert( matches.size() > 0 && "Can't merge two disjoint graphs without any matches.");
+    // The consumers in o_unit of the merged vars were computed from them and will read the
+    // kept vars instead. Only the absorbed part of the graph is visited.
+    for (const auto& match : matches) {
+      for (Var* consumer : match.second->getConsumers(o_unit.m_graph))
+	consumer->invalidate();
+    }
     // Merge the graph from o_unit into *this. The graphs should not have any common elements
     // since each unit is designed to have exclusive ownership over its variables.
     m_graph.absorbDisjoint(o_unit.m_graph, matches);
-    
+    m_order.clear();
+    o_unit.m_order.clear();
+
+    // The matched vars of o_unit are merged into ours and are dropped with o_unit.
+    std::unordered_set<Var*> merged{};
+    for (const auto& match : matches)
+      merged.insert(match.second);
     // transfer ownership from the other unit.
     // First all variables are moved from the other unit's containter except the matched ones.
-    for (int i{0}; uvptr& varuptr : o_unit.m_varsContainer) {
-      if (i < matches.size() && varuptr.get() == matches[i].second) { 
-	++i;   // Matched vars appear in order.
-      } else { 
+    for (uvptr& varuptr : o_unit.m_varsContainer) {
+      if (merged.count(varuptr.get()) == 0)
 	m_varsContainer.emplace_back(std::move(varuptr));
-      }
     }
-    // Also transfer leafs.
-    for (int i{0}; Variable* varptr : o_unit.m_leafs) {
-      if (i < matches.size() && varptr == matches[i].second) {
-	++i;
-      } else {
-	m_leafs.push_back(varptr);
-      }
+    // Also transfer leafs and the inputs which are not shared with this unit.
+    for (Var* varptr : o_unit.m_leafs) {
+      if (merged.count(varptr) == 0)
+	addLeaf(varptr);
+    }
+    for (Var* varptr : o_unit.m_inputs) {
+      if (merged.count(varptr) == 0)
+	m_inputs.push_back(varptr);
     }
     o_unit.m_varsContainer.clear(); // Now we clean the other object's list into its null state.
     o_unit.m_leafs.clear();
+    o_unit.m_inputs.clear();
+  }
+
+  /* Leafs of this and other are the same variable if they have the same name. */
+  std::vector<std::pair<Var*, Var*>> matchLeafs(const BasicUnit& o_unit) const
+  {
+    // Names are interned and indexed, so this is linear in the leafs of the other unit.
+    std::vector<std::pair<Var*, Var*>> matches{};
+    for (Var* o_leaf : o_unit.m_leafs) {
+      const auto it{ m_leafIndex.find(o_leaf->getSymbol()) };
+      if (it != m_leafIndex.end())
+	matches.emplace_back(it->second, o_leaf);
+    }
+    return matches;
   }
-  
-  void binaryOp(Unit& o_unit, const OperationBinary& operation) {    
-    assert(getInput().getName() == o_unit.getInput().getName()); // Only equal inputs for now.
-    
-    Variable& this_output{getOutput()};        // Save references to the outputs;
-    Variable& othr_output{o_unit.getOutput()}; //
-      
-    // Find the common leafs.
-    auto comparator{[](const Variable* v1, const Variable* v2) { // Variables are merged if they
-		      return v1->getName() == v2->getName();     // have the same name.
-		    }};
-    auto matches{ util::intersect(m_leafs, o_unit.m_leafs, comparator) };
-    // Until multiple inputs are allowed the inputs must provide at least one match.
-    assert( matches.size() > 0 && "Must have at least some matching variables.");
-    matchedMerge(o_unit, matches);    
+
+  void binaryOp(BasicUnit& o_unit, const BasicOperationBinary<T>& operation) {
+    Var& this_output{getOutput()};         // Save references to the outputs;
+    Var* othr_output{&o_unit.getOutput()}; //
+
+    // Find the common leafs. Units without common leafs are simply functions of all the
+    // inputs of both units.
+    auto matches{ matchLeafs(o_unit) };
+    for (const auto& [kept, merged] : matches) {
+      if (othr_output == merged)   // The other unit is just a leaf, i.e. Unit{Scalar{"x"}}.
+	othr_output = kept;
+    }
+    matchedMerge(o_unit, matches);
     // also, how do we know which add to use? More control flow will be requiered here.
-    auto res{ operation(m_graph, this_output, othr_output) };
+    auto res{ record(operation, this_output, *othr_output) };
     // No need to push back anything else than the result which is of course not a leaf
     m_varsContainer.push_back(std::move(res));
   }
-  
+
+  /* Sets the input values in the order of m_inputs. */
+  void bind(std::span<const T> inputValues) {
+    if (inputValues.size() != m_inputs.size()) {
+      std::stringstream ss{};
+      ss << "Unit has " << m_inputs.size() << " inputs but " << inputValues.size()
+	 << " values were given.";
+      throw InvalidOperationException(ss.str());
+    }
+    for (std::size_t i{0}; i < m_inputs.size(); ++i)
+      BasicScalar<T>::setValue(*m_inputs[i], inputValues[i]);
+  }
+
 public:
-  Unit(Scalar&& scalar) {
-    uvptr x{ std::make_unique<Scalar>(std::move(scalar)) }; // Move to heap for longer lifetime.
+  using value_type = T;
+
+  BasicUnit(BasicScalar<T>&& scalar) {
+    uvptr x{ std::make_unique<BasicScalar<T>>(std::move(scalar)) }; // Move to heap for longer lifetime.
     m_graph.addNode(x.get());
-    m_leafs.push_back(x.get());
+    addLeaf(x.get());
+    m_inputs.push_back(x.get());
     m_varsContainer.push_back(std::move(x));
   }
-  Variable& getInput() {
-    return *(m_varsContainer.front());
+  /**
+   * Every variable is cloned once and the pointers of the leafs, inputs, graph and cached
+   * evaluation order are remapped onto the clones. The copy keeps the values and stamps of
+   * the original, so it does not need to recompute anything.
+   * @brief Deep copy of the unit, i.e. a replica for another thread.
+   */
+  BasicUnit(const BasicUnit& other)
+    : m_cutoff{ other.m_cutoff }
+    , m_lazy{ other.m_lazy }
+    , m_recomputed{ other.m_recomputed }
+  {
+    std::unordered_map<Var*, Var*> clones{};
+    clones.reserve(other.m_varsContainer.size());
+    m_varsContainer.reserve(other.m_varsContainer.size());
+    for (const uvptr& var : other.m_varsContainer) {
+      m_varsContainer.push_back(var->clone());
+      clones.emplace(var.get(), m_varsContainer.back().get());
+    }
+    auto remap{ [&clones](Var* var) { return clones.at(var); } };
+    auto remapAll{ [&remap](const std::vector<Var*>& vars) {
+      std::vector<Var*> result{};
+      result.reserve(vars.size());
+      std::transform(vars.begin(), vars.end(), std::back_inserter(result), remap);
+      return result;
+    }};
+    for (Var* leaf : other.m_leafs)
+      addLeaf(remap(leaf));
+    m_inputs = remapAll(other.m_inputs);
+    m_order = remapAll(other.m_order);
+    m_graph = other.m_graph.remapped(remap);
   }
-  Variable& getOutput() {
+  /**
+   * @brief Rebuilds a unit from a compact graph, i.e. one read from a file. The first output
+   *        becomes the output of the unit and the bound inputs its inputs.
+   * @note Inputs the output does not depend on are not part of a compact graph. The other
+   *       leafs are parameters and get new anonymous names, since names from another unit or
+   *       process would match the parameters of the units this one is combined with.
+   */
+  explicit BasicUnit(const CompactGraph<T>& graph) {
+    const auto& nodes{ graph.getNodes() };
+    const auto values{ graph.getValues() };
+    if (graph.getOutputs().empty())
+      throw InvalidOperationException("A unit needs an output.");
+    std::vector<bool> bound(nodes.size(), false);
+    for (const std::uint32_t input : graph.getBoundInputs()) {
+      if (input != CompactNode::none)
+	bound.at(input) = true;
+    }
+    m_varsContainer.reserve(nodes.size());
+    for (std::size_t i{0}; i < nodes.size(); ++i) {
+      const bool parameter{ nodes[i].arity() == 0 && !bound[i] };
+      m_varsContainer.push_back(std::make_unique<BasicScalar<T>>(
+	parameter ? SymbolTable::anonymous() : nodes[i].name,
+	operationOf<T>(nodes[i].opcode), values[i]));
+      Var* var{ m_varsContainer.back().get() };
+      if (nodes[i].arity() == 0) {
+	m_graph.addNode(var);
+	addLeaf(var);
+      }
+      for (std::size_t k{0}; k < nodes[i].arity(); ++k)
+	m_graph.addConnection(m_varsContainer.at(nodes[i].inputs[k]).get(), var);
+    }
+    for (const std::uint32_t input : graph.getBoundInputs()) {
+      if (input != CompactNode::none)
+	m_inputs.push_back(m_varsContainer[input].get());
+    }
+    // The output is the last variable of the container.
+    std::swap(m_varsContainer.at(graph.getOutputs().front()), m_varsContainer.back());
+  }
+  BasicUnit(BasicUnit&&) = default;
+  BasicUnit& operator=(const BasicUnit& other) {
+    BasicUnit copy{ other };
+    return *this = std::move(copy);
+  }
+  BasicUnit& operator=(BasicUnit&&) = default;
+  /**
+   * @brief A deep copy of the unit, see the copy constructor.
+   */
+  BasicUnit clone() const {
+    return BasicUnit{ *this };
+  }
+  /**
+   * @brief The first input of the unit.
+   * @throws InvalidOperationException If the unit has no input, i.e. one loaded from a graph
+   *         without bound inputs.
+   */
+  Var& getInput() {
+    if (m_inputs.empty())
+      throw InvalidOperationException("The unit has no input.");
+    return *(m_inputs.front());
+  }
+  /**
+   * @brief All inputs of the unit in the order forward(std::span) binds them.
+   */
+  const std::vector<Var*>& getInputs() const {
+    return m_inputs;
+  }
+  Var& getOutput() {
     return *(m_varsContainer.back());
   }
-  Unit& add(Unit& o_unit) {
-    binaryOp(o_unit, scalarAdd);
+  BasicUnit& add(BasicUnit& o_unit) {
+    binaryOp(o_unit, basicScalarAdd<T>);
     return *this;
   }
-  Unit& add(double alpha) {
-    binaryOp(alpha, scalarAdd);
+  BasicUnit& add(BasicUnit&& o_unit) {
+    return add(o_unit);
+  }
+  BasicUnit& add(T alpha) {
+    binaryOp(alpha, basicScalarAdd<T>);
     return *this;
   }
-  Unit& mul(Unit& o_unit) {
-    binaryOp(o_unit, scalarMul);
+  BasicUnit& mul(BasicUnit& o_unit) {
+    binaryOp(o_unit, basicScalarMul<T>);
     return *this;
   }
-  Unit& mul(double mu) {
-    binaryOp(mu, scalarMul);
+  BasicUnit& mul(BasicUnit&& o_unit) {
+    return mul(o_unit);
+  }
+  BasicUnit& mul(T mu) {
+    binaryOp(mu, basicScalarMul<T>);
     return *this;
   }
-  Unit& sub(Unit& o_unit) {
-    binaryOp(o_unit, scalarSub);
+  BasicUnit& sub(BasicUnit& o_unit) {
+    binaryOp(o_unit, basicScalarSub<T>);
     return *this;
   }
-  Unit& sub(double sigma) {
-    binaryOp(sigma, scalarSub);
+  BasicUnit& sub(BasicUnit&& o_unit) {
+    return sub(o_unit);
+  }
+  BasicUnit& sub(T sigma) {
+    binaryOp(sigma, basicScalarSub<T>);
     return *this;
-  }  
-  Unit& div(Unit& o_unit) {
-    binaryOp(o_unit, scalarDiv);
+  }
+  BasicUnit& div(BasicUnit& o_unit) {
+    binaryOp(o_unit, basicScalarDiv<T>);
     return *this;
   }
-  Unit& div(double delta) {
-    binaryOp(delta, scalarDiv);
+  BasicUnit& div(BasicUnit&& o_unit) {
+    return div(o_unit);
+  }
+  BasicUnit& div(T delta) {
+    binaryOp(delta, basicScalarDiv<T>);
     return *this;
   }
-  Unit& xpn(Unit& o_unit) {
-    binaryOp(o_unit, scalarXpn);
+  BasicUnit& xpn(BasicUnit& o_unit) {
+    binaryOp(o_unit, basicScalarXpn<T>);
     return *this;
   }
-  Unit& xpn(double xi) {
-    binaryOp(xi, scalarXpn);
+  BasicUnit& xpn(BasicUnit&& o_unit) {
+    return xpn(o_unit);
+  }
+  BasicUnit& xpn(T xi) {
+    binaryOp(xi, basicScalarXpn<T>);
     return *this;
   }
-  Unit& log() {
-    unaryOp(scalarLog);
+  BasicUnit& log() {
+    unaryOp(basicScalarLog<T>);
     return *this;
   }
-  Unit& abs() {
-    unaryOp(scalarAbs);
+  BasicUnit& abs() {
+    unaryOp(basicScalarAbs<T>);
     return *this;
   }
-  Unit& exp() {
-    unaryOp(scalarExp);
+  BasicUnit& exp() {
+    unaryOp(basicScalarExp<T>);
     return *this;
   }
   /**
    * @brief Joins output of this unit with input of other unit.
+   * @note The remaining inputs of the other unit become inputs of this unit, unless they
+   *       share their name with one of the leafs of this unit.
    */
-  Unit& join(Unit& n_unit) {
+  BasicUnit& join(BasicUnit& n_unit) {
     const auto& thisOutLen{ this->getOutput().getLengths() };
-    const auto& othrInLen{ n_unit.getInput().getLengths() };    
+    const auto& othrInLen{ n_unit.getInput().getLengths() };
     if (thisOutLen.size() != othrInLen.size() || thisOutLen != othrInLen) {
-      throw InvalidOperationException("Joining elements have different sizes"); 
+      throw InvalidOperationException("Joining elements have different sizes");
     }
     // Input and output have equal dimensions.
-    std::vector<std::pair<Variable*, Variable*>> inOutMatch{    // Should delete input leaf after 
-      std::make_pair(&this->getOutput(), &n_unit.getInput()) }; // disjointAbsorb.
-    matchedMerge(n_unit, inOutMatch);
+    Var* joined{ &n_unit.getInput() };
+    std::vector<std::pair<Var*, Var*>> matches{    // Should delete input leaf after
+      std::make_pair(&this->getOutput(), joined) }; // disjointAbsorb.
+    // The other leafs are shared by name, the joined input is replaced by the output only.
+    for (const auto& match : matchLeafs(n_unit)) {
+      if (match.second != joined)
+	matches.push_back(match);
+    }
+    matchedMerge(n_unit, matches);
     return *this;
   }
-  // @note The output must be scalar.
-  double forward(double inputValue) {
+  BasicUnit& join(BasicUnit&& n_unit) {
+    return join(n_unit);
+  }
+  /**
+   * @brief Joins the units one after the other, i.e. a chain of layers. Every join costs
+   *        time proportional to the size of the joined unit only.
+   */
+  BasicUnit& join(std::span<BasicUnit> n_units) {
+    for (BasicUnit& n_unit : n_units)
+      join(n_unit);
+    return *this;
+  }
+  /**
+   * @brief Binds the values to the inputs in the order of getInputs() and forward propagates.
+   * @note The output must be scalar.
+   */
+  T forward(std::span<const T> inputValues) {
+    bind(inputValues);
+    update();
+    return BasicScalar<T>::value( getOutput() );
+  }
+  /**
+   * @brief The gradient of the output w.r.t. every input from a single backward pass.
+   * @return The partial derivatives in the order of getInputs().
+   * @note The output must be scalar.
+   */
+  std::vector<T> gradient(std::span<const T> inputValues) {
+    bind(inputValues);
+    update();
+    map<Var*, BasicGradient<T>> grad_table{ backProp_walk(m_graph, getOutput()) };
+    std::vector<T> grad(m_inputs.size(), T{0});
+    for (std::size_t i{0}; i < m_inputs.size(); ++i) {
+      const auto it{ grad_table.find(m_inputs[i]) };
+      if (it != grad_table.end())   // An input may not be connected to the output.
+	grad[i] = it->second[0];
+    }
+    return grad;
+  }
+  // @note The output must be scalar. Only the first input is set.
+  T forward(T inputValue) {
     // Setting the value for the input will result in a different output.
-    Scalar::setValue( getInput(), inputValue );
-    return Scalar::value( forwardProp(m_graph, getOutput()) );
+    BasicScalar<T>::setValue( getInput(), inputValue );
+    update();
+    return BasicScalar<T>::value( getOutput() );
   }
   // @note The output must be scalar.
-  double backward(double inputValue) {
-    Scalar::setValue( getInput(), inputValue );
-    forwardProp(m_graph, getOutput());
-    map<Variable*, Gradient> grad_table{ backProp_walk(m_graph, getOutput()) };
-    const Gradient& grad_input{ grad_table.at( &getInput()) };
+  T backward(T inputValue) {
+    map<Var*, BasicGradient<T>> grad_table{ gradients(inputValue) };
+    const BasicGradient<T>& grad_input{ grad_table.at( &getInput()) };
     assert(grad_input.size() == 1);
     return grad_input[0];
   }
+  /**
+   * @brief Forward and backward propagates and returns the gradients of all variables.
+   * @param seed The gradient of the output with itself. Anything else than 1 scales all
+   *             gradients, which is used for loss scaling.
+   * @note The output must be scalar.
+   */
+  map<Var*, BasicGradient<T>> gradients(T inputValue, T seed=T{1}) {
+    BasicScalar<T>::setValue( getInput(), inputValue );
+    update();
+    return backProp_walk(m_graph, getOutput(), BasicGradient<T>{seed});
+  }
+  /**
+   * @brief Like gradients(T, T), but binds a value to every input in the order of getInputs().
+   */
+  map<Var*, BasicGradient<T>> gradients(std::span<const T> inputValues, T seed=T{1}) {
+    bind(inputValues);
+    update();
+    return backProp_walk(m_graph, getOutput(), BasicGradient<T>{seed});
+  }
+  /**
+   * The forward and backward calls of the unit write into its variables, so a unit can only
+   * serve one thread. A compiled plan is immutable instead: every thread evaluates it into
+   * its own ExecutionContext and the graph is neither copied nor locked.
+   * @brief Compiles the output and inputs of the unit into a plan shared between threads.
+   * @note The plan refers to the variables of the unit, which must outlive it and must not be
+   *       changed while contexts read them. Recompile after changing the unit.
+   */
+  std::shared_ptr<const ExecutionPlan<T>> compile() const {
+    return std::make_shared<const ExecutionPlan<T>>(
+      m_graph, std::vector<Var*>{ m_varsContainer.back().get() }, m_inputs);
+  }
+  /**
+   * @brief A compact copy of the unit, see CompactGraph. Only the variables the output
+   *        depends on are kept.
+   * @note The copy is forward-only and the unit is left as it is, so memory peaks at both.
+   */
+  CompactGraph<T> compact() const {
+    return CompactGraph<T>{ *compile() };
+  }
+  /**
+   * @brief Freezes the unit into a forward-only model for serving. The model owns its
+   *        constants, i.e. the current parameters, and does not refer to the unit.
+   */
+  InferenceModel<T> freeze() const {
+    return InferenceModel<T>{ compact() };
+  }
+  /**
+   * @brief Saves the output, inputs and current parameters in the binary graph format.
+   */
+  void save(const std::string& path) const {
+    saveGraph(compact(), path);
+  }
+  /**
+   * @brief Loads a unit saved with save. To evaluate a file without building a unit, use
+   *        MappedGraph directly.
+   * @throws InvalidOperationException If the file is not a valid graph, see MappedGraph::verify.
+   */
+  static BasicUnit load(const std::string& path) {
+    const auto mapped{ MappedGraph<T>::open(path) };
+    if (!mapped.verify())
+      throw InvalidOperationException(path + " does not hold a valid graph.");
+    return BasicUnit{ mapped.toCompact() };
+  }
+  /**
+   * @brief The memory held by the variables and graph of the unit, compare with
+   *        compact().memoryUsage(). Only the forward-only compact copy meets the compact
+   *        footprint, the unit itself stays at the size of its variables.
+   */
+  MemoryUsage memoryUsage() const {
+    MemoryUsage usage{ m_varsContainer.size(), m_graph.memoryUsage() };
+    for (const uvptr& var : m_varsContainer) {
+      // The unique_ptr in the container, the scalar itself and its separately held value.
+      usage.bytes += sizeof(uvptr) + sizeof(BasicScalar<T>) + sizeof(T)
+	+ var->getLengths().capacity() * sizeof(int);
+    }
+    usage.bytes += (m_leafs.capacity() + m_inputs.capacity() + m_order.capacity()) * sizeof(Var*);
+    usage.bytes += m_leafIndex.size() * (sizeof(std::pair<const SymbolTable::Symbol, Var*>) + sizeof(void*))
+      + m_leafIndex.bucket_count() * sizeof(void*);
+    return usage;
+  }
+  /**
+   * @brief The leafs that are not inputs, i.e. the constants created by add(T), mul(T)
+   *        etc. These are the trainable parameters of the unit.
+   */
+  std::vector<Var*> getParameters() {
+    std::unordered_set<Var*> inputs(m_inputs.begin(), m_inputs.end());
+    std::vector<Var*> parameters{};
+    for (Var* varptr : m_leafs) {
+      if (inputs.count(varptr) == 0)
+	parameters.push_back(varptr);
+    }
+    return parameters;
+  }
+  /**
+   * @brief With early cutoff on, a variable recomputed to a bit-identical value does not
+   *        cause its consumers to be recomputed. On by default.
+   */
+  void setEarlyCutoff(bool cutoff) {
+    m_cutoff = cutoff;
+  }
+  /**
+   * Every operation normally computes its value when it is added, and the first forward
+   * pass computes it again since new variables are dirty. In lazy mode operations only add
+   * their variable and its edges, so building a large unit is pure bookkeeping and the values
+   * are produced by the first forward, gradient or gradients call. Off by default.
+   * @brief Whether operations added from now on skip computing their value.
+   * @note The values of lazily added variables, the output included, are meaningless until
+   *       the unit is propagated.
+   */
+  void setLazyBuild(bool lazy) {
+    m_lazy = lazy;
+  }
+  /**
+   * @brief The number of variables recomputed by the last forward pass. Only the variables
+   *        depending on inputs or parameters changed since the pass before are recomputed.
+   */
+  std::size_t getRecomputed() const {
+    return m_recomputed;
+  }
+  /**
+   * @brief The profiling counters of all passes since they were last reset. Profiling is off
+   *        until Profiler::enable is called.
+   */
+  static ProfileReport profile() {
+    return Profiler::report();
+  }
+  /**
+   * @brief Prints the profile as a table with one row per operation and phase.
+   */
+  static void printProfile(std::ostream& out=std::cout) {
+    out << Profiler::report();
+  }
   void printGraph() {
-    auto customPrint{ [] (Variable* varptr) -> void {
+    auto customPrint{ [] (Var* varptr) -> void {
       std::cout << *varptr;
     }};
   m_graph.printGraph(customPrint);
@@ -197,3 +587,6 @@ public:
   }
 };
 
+using Unit = BasicUnit<double>;
+
+#endif
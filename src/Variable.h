@@ -1,4 +1,3 @@
-
 // An inheritable class for the variables in the program.
 
 #ifndef VARIABLE_H
@@ -6,56 +5,99 @@
 
 #include "DirectedGraph.h"
 #include "Operation.h"
+#include "SymbolTable.h"
 #include <vector>
 #include <memory>
 #include <string>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
 
-class Variable
+/**
+ * @brief A variable in the computational graph holding values of type T.
+ */
+template <typename T>
+class BasicVariable
 {
-  using vptr = Variable*;
+  using vptr = BasicVariable*;
 private:
-  const std::string m_name{""};
-  const Operation& m_operation;
+  SymbolTable::Symbol m_name{ 0 };   // Interned, see SymbolTable.
+  const BasicOperation<T>& m_operation;
   bool m_flag{};
+  // Stamps from s_clock. m_version is when the value last changed and m_evaluated when it
+  // was last computed from its inputs, 0 meaning never, i.e. the value is dirty.
+  std::uint64_t m_version{ 0 };
+  std::uint64_t m_evaluated{ 0 };
+  inline static std::atomic<std::uint64_t> s_clock{ 0 };
 
 protected:
-  std::unique_ptr<double> m_memory{}; // initialized as nullptr
-  std::vector<int> m_lengths{}; 
+  std::unique_ptr<T> m_memory{}; // initialized as nullptr
+  std::vector<int> m_lengths{};
   /**
    * @param name Named variables are usually inputs.
    * @param operation The opeation that created the variable.
    * @param flag
    */
-  Variable(const std::string& name, const Operation& operation, bool flag=false)
-    : m_name{ name }
+  BasicVariable(const std::string& name, const BasicOperation<T>& operation, bool flag=false)
+    : m_name{ SymbolTable::intern(name) }
+    , m_operation{ operation }
+    , m_flag{ flag }
+  {}
+  BasicVariable(SymbolTable::Symbol symbol, const BasicOperation<T>& operation, bool flag=false)
+    : m_name{ symbol }
     , m_operation{ operation }
     , m_flag{ flag }
   {}
-  Variable(const Operation& operation, bool flag=false)
+  BasicVariable(const BasicOperation<T>& operation, bool flag=false)
     : m_operation{ operation }
     , m_flag{ flag }
   {}
-  
-  
+  BasicVariable(BasicVariable&&) = default;
+  /**
+   * @brief Deep copy, the memory is copied and the stamps are kept so that a copied value
+   *        is not considered dirty.
+   */
+  BasicVariable(const BasicVariable& other)
+    : m_name{ other.m_name }
+    , m_operation{ other.m_operation }
+    , m_flag{ other.m_flag }
+    , m_version{ other.m_version }
+    , m_evaluated{ other.m_evaluated }
+    , m_memory{ other.m_memory ? std::make_unique<T>(*other.m_memory) : nullptr }
+    , m_lengths{ other.m_lengths }
+  {}
+
+
 public:
+  using value_type = T;
+
+  virtual ~BasicVariable() = default;
+
+  /**
+   * @brief A deep copy of the variable with the same name, operation and value. The copy is
+   *        not part of any graph.
+   */
+  virtual std::unique_ptr<BasicVariable> clone() const = 0;
+
   /**
    * @brief Redirects the memory pointed to, deleting it in the process, to another memory block.
-   * @param 
+   * @param
    */
-  void overwriteMemory(std::unique_ptr<double> new_memory, std::vector<int> new_lengths)
+  void overwriteMemory(std::unique_ptr<T> new_memory, std::vector<int> new_lengths)
   {
     m_memory = std::move(new_memory);
     m_lengths = new_lengths;
+    markChanged();
   }
   /**
    * @param memory Memory that is to be copied to m_memory.
    */
-  //virtual void copyInto(const double* memory) = 0;    
+  //virtual void copyInto(const T* memory) = 0;
 
   /**
    * @return A pointer to the memory the object is holding.
    */
-  double* getMemoryPtr() const
+  T* getMemoryPtr() const
   { return m_memory.get(); }
 
   /**
@@ -64,7 +106,7 @@ public:
    */
   const std::vector<int>& getLengths() const
   { return m_lengths; }
-  
+
   /**
    * @brief Gets the consumers of this variable in the graph.
    * @param graph Directed graph from which the consumers are given.
@@ -72,25 +114,88 @@ public:
    */
   const std::vector<vptr>& getConsumers(const DirectedGraph<vptr>& graph)
   { return graph.getNodeConsumers(this); }
-  
+
  /**
   * @brief Gets the inputs of this variable in the graph.
   * @param graph Directed graph from which the inputs are given.
   * @return Reference to the vector of variable references.
   */
   const std::vector<vptr>& getInputs(const DirectedGraph<vptr>& graph)
-  { return graph.getNodeInputs(this); }  
-  
+  { return graph.getNodeInputs(this); }
+
   /**
    * @brief Gets the operation that created the variable.
    * @return Operation
    */
-  const Operation& getOperation() const
+  const BasicOperation<T>& getOperation() const
   { return m_operation; }
 
   const std::string& getName() const
+  { return SymbolTable::name(m_name); }
+
+  /**
+   * @brief The interned name. Variables have equal names exactly when their symbols are equal.
+   *        Anonymous symbols, see SymbolTable::anonymous, are equal to no other.
+   */
+  SymbolTable::Symbol getSymbol() const
   { return m_name; }
-  
+
+  /**
+   * @brief A new stamp, larger than every stamp handed out before.
+   */
+  static std::uint64_t nextStamp()
+  { return ++s_clock; }
+
+  /**
+   * @brief Whether two values are bit-identical, i.e. 0.0 and -0.0 differ.
+   */
+  static bool sameValue(T value1, T value2)
+  { return value1 == value2 && std::signbit(value1) == std::signbit(value2); }
+
+  /**
+   * @brief Records that the value was changed from outside the graph, i.e. a new input.
+   */
+  void markChanged()
+  { m_version = nextStamp(); }
+
+  /**
+   * @brief Records that the variable was computed from its inputs in the pass with stamp.
+   * @param previous The value before it was computed.
+   * @param cutoff If true the version is kept when the value did not change, so that
+   *               consumers do not need to be recomputed.
+   * @return Whether the version changed.
+   */
+  bool setEvaluated(std::uint64_t stamp, T previous, bool cutoff=true)
+  {
+    m_evaluated = stamp;
+    if (cutoff && sameValue(previous, *m_memory))
+      return false;
+    m_version = stamp;
+    return true;
+  }
+
+  /**
+   * @brief Marks the value as dirty so that the next incremental pass recomputes it.
+   */
+  void invalidate()
+  { m_evaluated = 0; }
+
+  /**
+   * @brief Whether the value must be recomputed given the current versions of its inputs.
+   */
+  bool isStale(const std::vector<vptr>& inputs) const
+  {
+    if (m_evaluated == 0)
+      return true;
+    for (const vptr input : inputs)
+      if (input->m_version > m_evaluated)
+	return true;
+    return false;
+  }
+
+  std::uint64_t getVersion() const
+  { return m_version; }
+
   void setTrue()
   { m_flag = true; }
 
@@ -102,17 +207,19 @@ public:
 
   bool operator! () const
   { return !m_flag; }
-  
+
   // Overloaded operator<<
-  friend std::ostream& operator<<(std::ostream& out, const Variable& v)
+  friend std::ostream& operator<<(std::ostream& out, const BasicVariable& v)
   {
     return v.print(out);
   }
-  
+
   // We'll rely on member function print() to do the actual printing
   // Because print() is a normal member function, it can be virtualized
   virtual std::ostream& print(std::ostream& out) const = 0;
-  
+
 };
 
+using Variable = BasicVariable<double>;
+
 #endif
@@ -1,73 +1,218 @@
 
 #include "backProp.h"
+#include "Profiler.h"
+#include "Exceptions.h"
 
-map<Variable*, Gradient> backProp_walk(DirectedGraph<Variable*>& graph, Variable& output)
+#include <atomic>
+#include <algorithm>
+#include <array>
+
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_walk(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& output)
 {
-  // Put the gradient of the output with itself.
-  map<Variable*, Gradient> grad_table{};
   // Set the output gradient to 1.0 Scalar.
-  Gradient initial_gradient{1.0};
-  grad_table[&output] = initial_gradient;
-  map<Variable*, int> visits{};
-  walk_gradient(output, graph, grad_table, visits);
-  return grad_table;  
+  return backProp_walk(graph, output, BasicGradient<T>{T{1}});
+}
+
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_walk(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& output,
+						       const BasicGradient<T>& seed)
+{
+  // Put the gradient of the output with itself.
+  return backProp_vjp(graph, std::vector<BasicVariable<T>*>{&output},
+		      std::vector<BasicGradient<T>>{seed});
+}
+
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_vjp(DirectedGraph<BasicVariable<T>*>& graph,
+						      const std::vector<BasicVariable<T>*>& outputs,
+						      const std::vector<BasicGradient<T>>& cotangents)
+{
+  assert(outputs.size() == cotangents.size() && "Need one cotangent per output.");
+  // The walk is for scalar graphs. Every gradient it adds comes from a cotangent and the span
+  // bprop, so checking the cotangents once is enough.
+  if (!std::all_of(cotangents.begin(), cotangents.end(),
+		   [](const BasicGradient<T>& c) { return c.size() == 1; }))
+    throw InvalidOperationException("The walk needs one scalar cotangent per output.");
+  map<BasicVariable<T>*, BasicGradient<T>> grad_table{};
+  for (std::size_t i{0}; i < outputs.size(); ++i) {
+    auto it{ grad_table.find(outputs[i]) };
+    if (it == grad_table.end())
+      grad_table[outputs[i]] = cotangents[i];
+    else
+      for (std::size_t j{0}; j < it->second.size(); ++j)
+	it->second[j] += cotangents[i][j];
+  }
+  // Only consumers which the outputs depend on will ever send a gradient, so a variable is
+  // complete once these have been walked. Every edge is counted, i.e. x*x gives x two.
+  const auto order{ graph.topologicalOrder(outputs) };
+  // Large scalar graphs are handed to the thread pool, with a fixed summation order so that
+  // the result does not depend on the schedule.
+  ParallelOptions options{};
+  options.deterministic = true;
+  if (order.size() >= options.threshold && options.concurrency() > 1) {
+    const ExecutionPlan<T> plan{ graph, outputs };
+    std::vector<T> seeds(outputs.size());
+    for (std::size_t i{0}; i < outputs.size(); ++i)
+      seeds[i] = cotangents[i][0];
+    const auto gradients{ backProp_parallel<T>(plan, seeds, options) };
+    grad_table.clear();
+    for (std::size_t i{0}; i < plan.size(); ++i)
+      grad_table[plan.getNodes()[i]] = BasicGradient<T>{ gradients[i] };
+    return grad_table;
+  }
+  map<BasicVariable<T>*, int> pending{};
+  for (BasicVariable<T>* var : order) {
+    pending.try_emplace(var, 0);
+    for (BasicVariable<T>* input : var->getInputs(graph))
+      ++pending[input];
+  }
+  // Start at the outputs no other output depends on. The rest are walked once complete.
+  for (BasicVariable<T>* output : outputs) {
+    if (pending.at(output) == 0) {
+      pending.at(output) = -1;   // Duplicate outputs are only walked once.
+      walk_gradient(*output, graph, grad_table, pending);
+    }
+  }
+  return grad_table;
 }
 
-static void walk_gradient(Variable& var, DirectedGraph<Variable*>& graph,
-		   map<Variable*, Gradient>& grad_table, map<Variable*, int>& visits) {
-  // We suppose that var has its final gradient computed. This is a kind of invariant for this
-  // method. This immediatly assures us that we have access to the following.
-  auto& gradient{ grad_table.at(&var) };
-  const auto& inputs{ var.getInputs(graph) };
-  auto updateGradient{ [] (Gradient& old_gradient, Gradient& new_gradient) {
-    assert(old_gradient.size() == new_gradient.size() && "Gradient size must match.");      
-    for (size_t i{0}; i < old_gradient.size(); ++i) {
-      old_gradient[i] += new_gradient[i];
+template <typename T>
+std::vector<T> backProp_parallel(const ExecutionPlan<T>& plan, std::span<const T> cotangents,
+				 const ParallelOptions& options)
+{
+  const auto& outputs{ plan.getOutputs() };
+  if (outputs.size() != cotangents.size())
+    throw InvalidOperationException("backProp_parallel needs one cotangent per output.");
+  const std::size_t n{ plan.size() };
+  const auto& nodes{ plan.getNodes() };
+  std::vector<T> gradients(n, T{0});
+  for (std::size_t i{0}; i < outputs.size(); ++i)
+    gradients[outputs[i]] += cotangents[i];
+  // Either one shared accumulator per variable or one slot per consumer edge. Types without
+  // lock-free atomics, i.e. long double on most targets, always use the slots.
+  constexpr bool lockFree{ std::atomic<T>::is_always_lock_free };
+  const bool deterministic{ options.deterministic || !lockFree };
+  std::vector<std::atomic<T>> adjoints(deterministic ? 0 : n);
+  std::vector<T> slots(deterministic ? plan.edges() : 0, T{0});
+  const auto& consumers{ plan.getForwardDependencies() };
+
+  auto walk{ [&](std::size_t i) {
+    Profiler::countVisit(ProfilePhase::Backward);
+    // All consumers are done, so the gradient of node i is final.
+    T gradient{ gradients[i] };
+    if (deterministic) {
+      const std::size_t begin{ consumers.successorOffsets[i] };
+      for (std::size_t e{begin}; e < consumers.successorOffsets[i + 1]; ++e)
+	gradient += slots[e];
+    } else if constexpr (lockFree) {
+      gradient += adjoints[i].load(std::memory_order_relaxed);
+    }
+    gradients[i] = gradient;
+    if (plan.isLeaf(i))
+      return;
+    const auto args{ plan.getInputs(i) };
+    const auto edgeSlots{ plan.getInputSlots(i) };
+    std::array<T, 2> values{};
+    std::array<T, 2> contributions{};
+    for (std::size_t k{0}; k < args.size(); ++k)
+      values[k] = *nodes[args[k]]->getMemoryPtr();
+    const auto& operation{ nodes[i]->getOperation() };
+    {
+      ProfileScope scope{ ProfilePhase::Backward, operation, nodes[i], (2 * args.size() + 1) * sizeof(T) };
+      operation.bprop({ values.data(), args.size() }, *nodes[i]->getMemoryPtr(), gradient,
+		      { contributions.data(), args.size() });
+    }
+    for (std::size_t k{0}; k < args.size(); ++k) {
+      if (deterministic)
+	slots[edgeSlots[k]] = contributions[k];
+      else if constexpr (lockFree)
+	adjoints[args[k]].fetch_add(contributions[k], std::memory_order_relaxed);
+    }
+  }};
+
+  if (options.concurrency() <= 1 || n < options.threshold) {
+    for (std::size_t i{n}; i-- > 0;)
+      walk(i);
+  } else {
+    scheduleParallel(plan.getBackwardDependencies(), options, walk);
+  }
+  return gradients;
+}
+
+template <typename T>
+static void walk_gradient(BasicVariable<T>& var, DirectedGraph<BasicVariable<T>*>& graph,
+			  map<BasicVariable<T>*, BasicGradient<T>>& grad_table,
+			  map<BasicVariable<T>*, int>& pending) {
+  // We suppose that a variable on the stack has its final gradient computed. This is a kind of
+  // invariant for this method. The stack replaces recursion so that long chains cannot
+  // overflow the call stack, and inputs are walked in the same order as recursion would.
+  // The gradients a variable sends to its inputs are all computed when it is pushed.
+  // Nodes are not checked here: operations give a variable at most two inputs, and a Unit
+  // validates its graph once when it builds its order, see validateNode.
+  struct Frame
+  {
+    const std::vector<BasicVariable<T>*>* inputs;
+    std::size_t next;
+    std::array<T, 2> contributions;
+  };
+  std::vector<Frame> stack{};
+  auto push{ [&](BasicVariable<T>* complete) {
+    Profiler::countVisit(ProfilePhase::Backward);
+    const auto& inputs{ complete->getInputs(graph) };
+    Frame frame{ &inputs, 0, {} };
+    if (!inputs.empty()) {
+      const auto& gradient{ grad_table.at(complete) };
+      std::array<T, 2> values{};
+      for (std::size_t k{0}; k < inputs.size(); ++k)
+	values[k] = *inputs[k]->getMemoryPtr();
+      const auto& operation{ complete->getOperation() };
+      ProfileScope scope{ ProfilePhase::Backward, operation, complete,
+			  (2 * inputs.size() + 1) * sizeof(T) };
+      operation.bprop({ values.data(), inputs.size() }, *complete->getMemoryPtr(), gradient[0],
+		      { frame.contributions.data(), inputs.size() });
     }
+    stack.push_back(frame);
   }};
-  for (auto inputVar_ptr : inputs) {
-    // For the variable pointed to by inputVar_ptr we woult like to compute its (or part of
-    // its) gradient.
-    auto& operation{ var.getOperation() };   // Lol don't forget to get a reference!!!!!
-    Gradient var_gradient{ operation.bprop(inputs, *inputVar_ptr, gradient) };
-    if (inputVar_ptr->getConsumers(graph).size() == 1) {
-      // This means that this input only has one consumer which must be var.
-      // Thus we can store the gradient as a new variable and call the function again.
-      grad_table[inputVar_ptr] = std::move(var_gradient);
-      walk_gradient(*inputVar_ptr, graph, grad_table, visits);
-    } else if (inputVar_ptr->getConsumers(graph).size() > 1
-	       && visits.find(inputVar_ptr) == visits.end()) {
-      // This means that the input has more than one consumer and must therefore have its
-      // gradient added to it multiple times.	  
-      // This is also the first time this element is accessed
+  push(&var);
+  while (!stack.empty()) {
+    Frame& frame{ stack.back() };
+    const auto& inputs{ *frame.inputs };
+    if (frame.next == inputs.size()) {
+      stack.pop_back();
+      continue;
+    }
+    const std::size_t k{ frame.next++ };
+    BasicVariable<T>* inputVar_ptr{ inputs[k] };
+    const T contribution{ frame.contributions[k] };
+    // A frame with nothing left is dropped before its input is pushed, so that a chain does
+    // not grow the stack.
+    if (frame.next == inputs.size())
+      stack.pop_back();
+    auto it{ grad_table.find(inputVar_ptr) };
+    if (it == grad_table.end()) {
+      // This is the first time this element is accessed.
       // We therefore add its entry to the grad table:
-      grad_table[inputVar_ptr] = std::move(var_gradient);
-      // We have one visit.
-      visits[inputVar_ptr] = 1;	  
-      // We don't want to keep going since this variable needs more gradient calculations.
-    } else if (inputVar_ptr->getConsumers(graph).size() > 1
-	       && visits.at(inputVar_ptr)+1
-	       < static_cast<int>(inputVar_ptr->getConsumers(graph).size()) ) {
-      // Here we have already visited the variable once but this is not the last visit.
-      updateGradient(grad_table[inputVar_ptr], var_gradient);
-      visits[inputVar_ptr] += 1;
-    } else if (inputVar_ptr->getConsumers(graph).size() > 1
-	       && visits.at(inputVar_ptr)+1 ==
-	       static_cast<int>(inputVar_ptr->getConsumers(graph).size()) ) {
-      // We are now at the last visit of the walker...
-      updateGradient(grad_table[inputVar_ptr], var_gradient);
-      // ...so no need to keep the element around since gradient is computed..
-      visits.erase(inputVar_ptr);
-      // Now we can keep going.
-      walk_gradient(*inputVar_ptr, graph, grad_table, visits);
+      grad_table[inputVar_ptr] = BasicGradient<T>{ contribution };
     } else {
+      // Either another consumer or a cotangent seed has already contributed.
+      it->second[0] += contribution;
+    }
+    int& remaining{ pending.at(inputVar_ptr) };
+    if (--remaining == 0) {
+      // That was the last consumer so the gradient is computed and we can keep going.
+      push(inputVar_ptr);
+    } else if (remaining < 0) {
       throw BadWalkException("An unexpected condition occurred in the graph");
-    }     
+    }
+    // Otherwise this variable needs more gradient calculations before we continue.
   }
-  return;
 }
 
-void printGradTable(const map<Variable*, Gradient>& grad_table) {
+template <typename T>
+void printGradTable(const map<BasicVariable<T>*, BasicGradient<T>>& grad_table) {
   for (const auto& kv_pair : grad_table) {
     std::cout << *kv_pair.first << '\n';
     for (auto val : kv_pair.second) {
@@ -77,4 +222,36 @@ void printGradTable(const map<Variable*, Gradient>& grad_table) {
   }  
 }
 
+template map<BasicVariable<float>*, BasicGradient<float>>
+backProp_walk(DirectedGraph<BasicVariable<float>*>&, BasicVariable<float>&);
+template map<BasicVariable<float>*, BasicGradient<float>>
+backProp_walk(DirectedGraph<BasicVariable<float>*>&, BasicVariable<float>&, const BasicGradient<float>&);
+template map<BasicVariable<float>*, BasicGradient<float>>
+backProp_vjp(DirectedGraph<BasicVariable<float>*>&, const std::vector<BasicVariable<float>*>&,
+	     const std::vector<BasicGradient<float>>&);
+template map<BasicVariable<double>*, BasicGradient<double>>
+backProp_walk(DirectedGraph<BasicVariable<double>*>&, BasicVariable<double>&);
+template map<BasicVariable<double>*, BasicGradient<double>>
+backProp_walk(DirectedGraph<BasicVariable<double>*>&, BasicVariable<double>&, const BasicGradient<double>&);
+template map<BasicVariable<double>*, BasicGradient<double>>
+backProp_vjp(DirectedGraph<BasicVariable<double>*>&, const std::vector<BasicVariable<double>*>&,
+	     const std::vector<BasicGradient<double>>&);
+template map<BasicVariable<long double>*, BasicGradient<long double>>
+backProp_walk(DirectedGraph<BasicVariable<long double>*>&, BasicVariable<long double>&);
+template map<BasicVariable<long double>*, BasicGradient<long double>>
+backProp_walk(DirectedGraph<BasicVariable<long double>*>&, BasicVariable<long double>&, const BasicGradient<long double>&);
+template map<BasicVariable<long double>*, BasicGradient<long double>>
+backProp_vjp(DirectedGraph<BasicVariable<long double>*>&, const std::vector<BasicVariable<long double>*>&,
+	     const std::vector<BasicGradient<long double>>&);
+
+template std::vector<float> backProp_parallel(const ExecutionPlan<float>&, std::span<const float>,
+					      const ParallelOptions&);
+template std::vector<double> backProp_parallel(const ExecutionPlan<double>&, std::span<const double>,
+					       const ParallelOptions&);
+template std::vector<long double> backProp_parallel(const ExecutionPlan<long double>&,
+						    std::span<const long double>,
+						    const ParallelOptions&);
 
+template void printGradTable(const map<BasicVariable<float>*, BasicGradient<float>>&);
+template void printGradTable(const map<BasicVariable<double>*, BasicGradient<double>>&);
+template void printGradTable(const map<BasicVariable<long double>*, BasicGradient<long double>>&);
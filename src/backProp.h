@@ -4,31 +4,89 @@
 
 #include "Variable.h"
 #include "DirectedGraph.h"
+#include "ExecutionPlan.h"
+#include "Scheduler.h"
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <span>
 
 
 using uvptr = std::unique_ptr<Variable>;
-using Gradient = std::vector<double>;
 
 template <typename V, typename K>
 using map = std::unordered_map<V, K>;
 
 /**
  * @brief        Functions that computes the gradient for all Variables in graph using my method
- *               which is a simple graph walk. 
+ *               which is a simple graph walk.
  *
- *               This will work under the assumption that we want to compute all gradients 
- *               and that there is only one output in the computational graph.
+ *               This will work under the assumption that we want to compute all gradients
+ *               of the one output. See backProp_vjp for several outputs.
  * @param graph  The computational graph.
  * @param output The scalar output of the computational graph.
- * @return       A map of Variable* -> Gradient. 
+ * @return       A map of Variable* -> Gradient.
  */
-map<Variable*, Gradient> backProp_walk(DirectedGraph<Variable*>& graph, Variable& output);
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_walk(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& output);
 
-static void walk_gradient(Variable& var, DirectedGraph<Variable*>& graph,
-		   map<Variable*, Gradient>& grad_table, map<Variable*, int>& visits);
-void printGradTable(const map<Variable*, Gradient>& grad_table);
+/**
+ * @brief        Same as backProp_walk(graph, output) but seeds the walk with a given gradient
+ *               of the output instead of 1.0, i.e. a loss scale for mixed precision training.
+ * @param seed   The gradient of the output with itself.
+ */
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_walk(DirectedGraph<BasicVariable<T>*>& graph,
+						       BasicVariable<T>& output,
+						       const BasicGradient<T>& seed);
+
+/**
+ * Reverse mode differentiation of several outputs at once. Outputs may be intermediate
+ * variables consumed by other outputs, their cotangent is then added to what they receive
+ * from their consumers. One walk over the graph gives the sum over the outputs of
+ * cotangent^T * Jacobian for every variable.
+ * @brief            Vector-Jacobian product.
+ * @param graph      The computational graph.
+ * @param outputs    The variables the cotangents belong to.
+ * @param cotangents One gradient per output, i.e. {1.0} to get the gradient of that output.
+ * @return           A map of Variable* -> Gradient for every variable the outputs depend on.
+ * @throws InvalidOperationException If a cotangent is not a scalar.
+ * @note             Scalar graphs with at least ParallelOptions::threshold variables run on
+ *                   the global pool, see backProp_parallel.
+ */
+template <typename T>
+map<BasicVariable<T>*, BasicGradient<T>> backProp_vjp(DirectedGraph<BasicVariable<T>*>& graph,
+						      const std::vector<BasicVariable<T>*>& outputs,
+						      const std::vector<BasicGradient<T>>& cotangents);
+
+/**
+ * Reverse mode differentiation on several threads. A variable is walked once the atomic
+ * count of its consumers that have not sent it a gradient reaches zero, see
+ * scheduleParallel. Consumers add their gradient to the adjoint of an input with an atomic
+ * add, so no locks are taken. With options.deterministic every consumer edge instead writes
+ * its own slot and the slots are summed in a fixed order once the input is complete, which
+ * gives bit-identical results on every run at the cost of one slot per edge. Value types
+ * without lock-free atomics, i.e. long double on most targets, always use the slots.
+ * @brief            Parallel vector-Jacobian product of a compiled scalar graph.
+ * @param plan       A compiled, forward propagated graph.
+ * @param cotangents One value per output of the plan.
+ * @param options    Number of threads, the size threshold and deterministic summation.
+ * @return           The gradient of every variable of the plan, indexed like plan.getNodes().
+ */
+template <typename T>
+std::vector<T> backProp_parallel(const ExecutionPlan<T>& plan, std::span<const T> cotangents,
+				 const ParallelOptions& options={});
+
+/**
+ * @brief Walks the gradient from var to its inputs. An input is walked once pending, the
+ *        number of its consumers which have not yet sent it a gradient, reaches zero.
+ */
+template <typename T>
+static void walk_gradient(BasicVariable<T>& var, DirectedGraph<BasicVariable<T>*>& graph,
+			  map<BasicVariable<T>*, BasicGradient<T>>& grad_table,
+			  map<BasicVariable<T>*, int>& pending);
+template <typename T>
+void printGradTable(const map<BasicVariable<T>*, BasicGradient<T>>& grad_table);
 
 #endif
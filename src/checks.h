@@ -4,37 +4,58 @@
 
 
 #include "Variable.h"
+#include "Operation.h"
+#include "Exceptions.h"
 #include <cassert>
+#include <cstddef>
 
-using Gradient = std::vector<double>;
+template <typename T>
+inline bool isScalar(const BasicVariable<T>& var) { return (var.getLengths().size() == 0); }
 
-inline bool isScalar(const Variable& var) { return (var.getLengths().size() == 0); }
-
-inline bool validateScalarBinaryBprop(const std::vector<Variable*>& inputs,
-				      const Variable& diff_var,
-				      const Gradient& gradient)
+template <typename T>
+inline bool validateScalarBinaryBprop(const std::vector<BasicVariable<T>*>& inputs,
+				      const BasicVariable<T>& diff_var,
+				      const BasicGradient<T>& gradient)
 {
   assert(inputs.size() == 2 && "For binary operator we must have 2 inputs only.");
   assert( isScalar(diff_var) );
   for (auto var_ptr : inputs)
-    assert( isScalar(*var_ptr) );    
+    assert( isScalar(*var_ptr) );
   assert(gradient.size() == 1 && "For scalar operator the gradient for any diff_var is 1D.");
   return true;
 }
 
-inline bool validateScalarUnaryBprop(const std::vector<Variable*>& inputs,
-				      const Variable& diff_var,
-				      const Gradient& gradient)
+template <typename T>
+inline bool validateScalarUnaryBprop(const std::vector<BasicVariable<T>*>& inputs,
+				     const BasicVariable<T>& diff_var,
+				     const BasicGradient<T>& gradient)
 {
   assert(inputs.size() == 1 && "For unary operator we must have 1 input only.");
   assert( isScalar(diff_var) );
   for (auto var_ptr : inputs)
-    assert( isScalar(*var_ptr) );    
+    assert( isScalar(*var_ptr) );
   assert(gradient.size() == 1 && "For scalar operator the gradient for any diff_var is 1D.");
   assert(inputs[0] == &diff_var && "Only input should be diff_var");
   return true;
 }
 
-
+/**
+ * The asserts above run on every call of bop, uop and bprop. Compiled graphs are checked
+ * once with this instead, after which the engines evaluate them without any checks.
+ * @brief Throws an InvalidOperationException unless var is a scalar with as many inputs as
+ *        its operation takes, i.e. none for an Input.
+ * @param arity The number of inputs of var in its graph.
+ */
+template <typename T>
+inline void validateNode(const BasicVariable<T>& var, std::size_t arity)
+{
+  if (!isScalar(var))
+    throw InvalidOperationException("Only scalar variables can be evaluated.");
+  const BasicOperation<T>& operation{ var.getOperation() };
+  const std::size_t expected{ (operation.getOpCode() == OpCode::Input) ? 0u
+			      : operation.isBinary() ? 2u : 1u };
+  if (arity != expected)
+    throw InvalidOperationException("A variable has a different number of inputs than its operation takes.");
+}
 
 #endif
@@ -1,28 +1,220 @@
 
 #include "forwardProp.h"
+#include "Profiler.h"
 
-const Variable& forwardProp(DirectedGraph<Variable*>& graph, Variable& output) {
-  assert(output.getConsumers(graph).size() == 0 && "Output for a unit cannot have consumers.");
-  visit(graph, output);
+#include <unordered_map>
+#include <array>
+#include <cassert>
+
+template <typename T>
+const BasicVariable<T>& forwardProp(DirectedGraph<BasicVariable<T>*>& graph, BasicVariable<T>& output) {
+  visit(graph, output, BasicVariable<T>::nextStamp());
   return output;
 }
 
-static void visit(DirectedGraph<Variable*>& graph, Variable& currentVar) {      
-  if (currentVar.getOperation() == input) return; // Early return at leaf.
-  assert(currentVar.getInputs(graph).size() == 1 || currentVar.getInputs(graph).size() == 2);
-  for (Variable* input : currentVar.getInputs(graph)) {
-    visit(graph, *input);
-  }
-  // When all inputs are visited the current node is updated.
-  // In the future the updating can be made into a recursive function call for multithreading.
+/**
+ * @brief Updates the value of a single variable from the values of its inputs.
+ * @param stamp The stamp of the current pass, recorded as the variable's evaluation time.
+ * @param cutoff Keep the version of the variable if its value did not change.
+ * @return Whether the value changed.
+ */
+template <typename T>
+static bool evaluate(DirectedGraph<BasicVariable<T>*>& graph, BasicVariable<T>& currentVar,
+		     std::uint64_t stamp, bool cutoff=true) {
+  const T previous{ *currentVar.getMemoryPtr() };
+  const auto& inputs{ currentVar.getInputs(graph) };
+  ProfileScope scope{ ProfilePhase::Forward, currentVar.getOperation(), &currentVar,
+		      (inputs.size() + 1) * sizeof(T) };
   if (currentVar.getOperation().isUnary()) {
-    const Variable& input{ *currentVar.getInputs(graph).at(0) };
+    const BasicVariable<T>& input{ *currentVar.getInputs(graph).at(0) };
     currentVar.getOperation().uop(input, currentVar);
   } else if (currentVar.getOperation().isBinary()) {
-    const Variable& linput{ *currentVar.getInputs(graph).at(0) };
-    const Variable& rinput{ *currentVar.getInputs(graph).at(1) };
+    const BasicVariable<T>& linput{ *currentVar.getInputs(graph).at(0) };
+    const BasicVariable<T>& rinput{ *currentVar.getInputs(graph).at(1) };
     currentVar.getOperation().bop(linput, rinput, currentVar);
   }
+  return currentVar.setEvaluated(stamp, previous, cutoff);
+}
+
+/**
+ * @brief Like evaluate, but through the value kernels which do not check the variables. The
+ *        variable must have been validated, see validateNode.
+ */
+template <typename T>
+static bool evaluateUnchecked(const std::vector<BasicVariable<T>*>& inputs,
+			      BasicVariable<T>& currentVar, std::uint64_t stamp, bool cutoff) {
+  T* value{ currentVar.getMemoryPtr() };
+  const T previous{ *value };
+  const auto& operation{ currentVar.getOperation() };
+  ProfileScope scope{ ProfilePhase::Forward, operation, &currentVar, (inputs.size() + 1) * sizeof(T) };
+  std::array<T, 2> args{};
+  for (std::size_t k{0}; k < inputs.size(); ++k)
+    args[k] = *inputs[k]->getMemoryPtr();
+  *value = operation.eval({ args.data(), inputs.size() });
+  return currentVar.setEvaluated(stamp, previous, cutoff);
+}
+
+template <typename T>
+void forwardProp(DirectedGraph<BasicVariable<T>*>& graph,
+		 const std::vector<BasicVariable<T>*>& outputs) {
+  const auto order{ graph.topologicalOrder(outputs) };
+  // Large graphs are handed to the thread pool.
+  const ParallelOptions options{};
+  if (order.size() >= options.threshold && options.concurrency() > 1) {
+    forwardProp_parallel(ExecutionPlan<T>{ graph, outputs }, options);
+    return;
+  }
+  const std::uint64_t stamp{ BasicVariable<T>::nextStamp() };
+  for (BasicVariable<T>* var : order) {
+    Profiler::countVisit(ProfilePhase::Forward);
+    if (var->getOperation() == basicInput<T>) continue;
+    evaluate(graph, *var, stamp);
+  }
+}
+
+template <typename T>
+std::size_t forwardProp_incremental(DirectedGraph<BasicVariable<T>*>& graph,
+				    const std::vector<BasicVariable<T>*>& order, bool cutoff) {
+  const std::uint64_t stamp{ BasicVariable<T>::nextStamp() };
+  std::size_t recomputed{ 0 };
+  for (BasicVariable<T>* var : order) {
+    Profiler::countVisit(ProfilePhase::Forward);
+    if (var->getOperation() == basicInput<T>) continue;
+    // Only variables downstream of a changed variable are recomputed.
+    const auto& inputs{ var->getInputs(graph) };
+    if (!var->isStale(inputs)) continue;
+    evaluateUnchecked(inputs, *var, stamp, cutoff);
+    ++recomputed;
+  }
+  return recomputed;
+}
+
+/**
+ * @brief Updates node i of a plan from the values of its inputs.
+ */
+template <typename T>
+static void evaluate(const ExecutionPlan<T>& plan, std::size_t i, std::uint64_t stamp) {
+  const auto& nodes{ plan.getNodes() };
+  BasicVariable<T>& currentVar{ *nodes[i] };
+  const auto args{ plan.getInputs(i) };
+  T* value{ currentVar.getMemoryPtr() };
+  const T previous{ *value };
+  const auto& operation{ currentVar.getOperation() };
+  ProfileScope scope{ ProfilePhase::Forward, operation, &currentVar, (args.size() + 1) * sizeof(T) };
+  // The plan validated its nodes, so the unchecked value kernels are used.
+  std::array<T, 2> values{};
+  for (std::size_t k{0}; k < args.size(); ++k)
+    values[k] = *nodes[args[k]]->getMemoryPtr();
+  *value = operation.eval({ values.data(), args.size() });
+  currentVar.setEvaluated(stamp, previous);
+}
+
+template <typename T>
+void forwardProp_parallel(const ExecutionPlan<T>& plan, const ParallelOptions& options) {
+  const std::uint64_t stamp{ BasicVariable<T>::nextStamp() };
+  if (options.concurrency() <= 1 || plan.size() < options.threshold) {
+    for (std::size_t i{0}; i < plan.size(); ++i) {
+      Profiler::countVisit(ProfilePhase::Forward);
+      if (!plan.isLeaf(i))
+	evaluate(plan, i, stamp);
+    }
+    return;
+  }
+  scheduleParallel(plan.getForwardDependencies(), options, [&](std::size_t i) {
+    Profiler::countVisit(ProfilePhase::Forward);
+    if (!plan.isLeaf(i))
+      evaluate(plan, i, stamp);
+  });
+}
+
+template <typename T>
+std::vector<T> forwardProp_jvp(DirectedGraph<BasicVariable<T>*>& graph,
+			       const std::vector<BasicVariable<T>*>& inputs,
+			       std::span<const T> tangents,
+			       const std::vector<BasicVariable<T>*>& outputs) {
+  assert(inputs.size() == tangents.size() && "Need one tangent per input.");
+  std::unordered_map<BasicVariable<T>*, T> tangent{};
+  for (std::size_t i{0}; i < inputs.size(); ++i)
+    tangent[inputs[i]] += tangents[i];
+  for (BasicVariable<T>* var : graph.topologicalOrder(outputs)) {
+    if (var->getOperation() == basicInput<T> || tangent.count(var) == 1)
+      continue;   // Leafs without a tangent are constant.
+    const auto& args{ var->getInputs(graph) };
+    // The partials of all operands from one bprop with a unit gradient.
+    std::array<T, 2> values{};
+    std::array<T, 2> partials{};
+    for (std::size_t k{0}; k < args.size(); ++k)
+      values[k] = *args[k]->getMemoryPtr();
+    var->getOperation().bprop({ values.data(), args.size() }, *var->getMemoryPtr(), T{1},
+			      { partials.data(), args.size() });
+    T dot{0};
+    for (std::size_t k{0}; k < args.size(); ++k) {
+      const auto it{ tangent.find(args[k]) };
+      if (it == tangent.end() || it->second == T{0})
+	continue;
+      // Repeated inputs, i.e. x*x, are visited once per edge just like in the backward walk.
+      dot += partials[k] * it->second;
+    }
+    tangent[var] = dot;
+  }
+  std::vector<T> result(outputs.size(), T{0});
+  for (std::size_t i{0}; i < outputs.size(); ++i) {
+    const auto it{ tangent.find(outputs[i]) };
+    if (it != tangent.end())
+      result[i] = it->second;
+  }
+  return result;
+}
+
+template <typename T>
+static void visit(DirectedGraph<BasicVariable<T>*>& graph, BasicVariable<T>& currentVar,
+		  std::uint64_t stamp) {
+  // Shared variables are reached once per path, which the visit count makes visible.
+  Profiler::countVisit(ProfilePhase::Forward);
+  if (currentVar.getOperation() == basicInput<T>) return; // Early return at leaf.
+  assert(currentVar.getInputs(graph).size() == 1 || currentVar.getInputs(graph).size() == 2);
+  for (BasicVariable<T>* input : currentVar.getInputs(graph)) {
+    visit(graph, *input, stamp);
+  }
+  // When all inputs are visited the current node is updated.
+  // In the future the updating can be made into a recursive function call for multithreading.
+  evaluate(graph, currentVar, stamp);
   return;
 }
 
+template const BasicVariable<float>& forwardProp(DirectedGraph<BasicVariable<float>*>&,
+						 BasicVariable<float>&);
+template const BasicVariable<double>& forwardProp(DirectedGraph<BasicVariable<double>*>&,
+						  BasicVariable<double>&);
+template const BasicVariable<long double>& forwardProp(DirectedGraph<BasicVariable<long double>*>&,
+						       BasicVariable<long double>&);
+
+template std::size_t forwardProp_incremental(DirectedGraph<BasicVariable<float>*>&,
+					     const std::vector<BasicVariable<float>*>&, bool);
+template void forwardProp(DirectedGraph<BasicVariable<float>*>&,
+			  const std::vector<BasicVariable<float>*>&);
+template std::size_t forwardProp_incremental(DirectedGraph<BasicVariable<double>*>&,
+					     const std::vector<BasicVariable<double>*>&, bool);
+template void forwardProp(DirectedGraph<BasicVariable<double>*>&,
+			  const std::vector<BasicVariable<double>*>&);
+template std::size_t forwardProp_incremental(DirectedGraph<BasicVariable<long double>*>&,
+					     const std::vector<BasicVariable<long double>*>&, bool);
+template void forwardProp(DirectedGraph<BasicVariable<long double>*>&,
+			  const std::vector<BasicVariable<long double>*>&);
+
+template void forwardProp_parallel(const ExecutionPlan<float>&, const ParallelOptions&);
+template void forwardProp_parallel(const ExecutionPlan<double>&, const ParallelOptions&);
+template void forwardProp_parallel(const ExecutionPlan<long double>&, const ParallelOptions&);
+
+template std::vector<float> forwardProp_jvp(DirectedGraph<BasicVariable<float>*>&,
+					    const std::vector<BasicVariable<float>*>&,
+					    std::span<const float>,
+					    const std::vector<BasicVariable<float>*>&);
+template std::vector<double> forwardProp_jvp(DirectedGraph<BasicVariable<double>*>&,
+					     const std::vector<BasicVariable<double>*>&,
+					     std::span<const double>,
+					     const std::vector<BasicVariable<double>*>&);
+template std::vector<long double> forwardProp_jvp(DirectedGraph<BasicVariable<long double>*>&,
+						  const std::vector<BasicVariable<long double>*>&,
+						  std::span<const long double>,
+						  const std::vector<BasicVariable<long double>*>&);
@@ -5,20 +5,85 @@
 #include "Variable.h"
 #include "DirectedGraph.h"
 #include "input_constant.h"
+#include "ExecutionPlan.h"
+#include "Scheduler.h"
 #include <vector>
+#include <span>
+#include <cstdint>
 
 /**
  * @brief Sets the values of the computational graph. This side effect is the main purpose.
- * @param graph A computational graph representing a function with one output.
- * @param The output variable.
+ * @param graph A computational graph.
+ * @param The output variable. It may also be an intermediate node with consumers, in which
+ *        case only the part of the graph it depends on is evaluated.
  */
-const Variable& forwardProp(DirectedGraph<Variable*>& graph, Variable& output);
+template <typename T>
+const BasicVariable<T>& forwardProp(DirectedGraph<BasicVariable<T>*>& graph, BasicVariable<T>& output);
+
+/**
+ * @brief Sets the values of every output, evaluating each node they depend on exactly once.
+ * @param graph A computational graph.
+ * @param outputs The output variables, which may consume each other.
+ * @note Graphs with at least ParallelOptions::threshold variables run on the global pool.
+ */
+template <typename T>
+void forwardProp(DirectedGraph<BasicVariable<T>*>& graph,
+		 const std::vector<BasicVariable<T>*>& outputs);
+
+/**
+ * Every variable records when its value last changed and when it was last computed. A
+ * variable is only recomputed when one of its inputs changed after that, so after changing
+ * a few inputs with Scalar::setValue only their cone of influence is evaluated.
+ * @brief Forward propagation that skips variables whose inputs did not change.
+ * @param graph A computational graph.
+ * @param order The variables to update in topological order, see
+ *              DirectedGraph::topologicalOrder. Callers evaluating the same outputs
+ *              repeatedly should keep it around.
+ * @param cutoff If true a recomputed variable whose value is bit-identical to its previous
+ *               value does not cause its consumers to be recomputed.
+ * @return The number of recomputed variables.
+ * @note The variables are evaluated without the checks of the operations, validate the
+ *       order once when it is built, see validateNode.
+ */
+template <typename T>
+std::size_t forwardProp_incremental(DirectedGraph<BasicVariable<T>*>& graph,
+				    const std::vector<BasicVariable<T>*>& order, bool cutoff=true);
+
+/**
+ * Independent branches of the graph are evaluated concurrently. Every node waits for a
+ * counter of unevaluated inputs to reach zero and is then picked up by one of the threads,
+ * see scheduleParallel. Plans smaller than the threshold are evaluated on the calling thread.
+ * @brief Forward propagation of a compiled graph on several threads.
+ * @param plan The compiled graph. Its variables must not be used by other threads meanwhile.
+ * @param options Number of threads and the size threshold.
+ */
+template <typename T>
+void forwardProp_parallel(const ExecutionPlan<T>& plan, const ParallelOptions& options={});
+
+/**
+ * Forward mode differentiation. The tangent of every node is the sum over its inputs of the
+ * local partial derivative, given by the operation's bprop with a unit gradient, times the
+ * tangent of the input. One call gives the directional derivative of all outputs.
+ * @brief Jacobian-vector product.
+ * @param graph A forward propagated computational graph.
+ * @param inputs The variables the tangents belong to.
+ * @param tangents One tangent per input.
+ * @param outputs The variables whose tangents are wanted.
+ * @return The tangent of each output, i.e. J*tangents.
+ */
+template <typename T>
+std::vector<T> forwardProp_jvp(DirectedGraph<BasicVariable<T>*>& graph,
+			       const std::vector<BasicVariable<T>*>& inputs,
+			       std::span<const T> tangents,
+			       const std::vector<BasicVariable<T>*>& outputs);
 
 /**
  * @note This method only works for the unit as long as we have ONE output and as long
- *       as the Directed graph is acyclical, which must be the case in a computational 
+ *       as the Directed graph is acyclical, which must be the case in a computational
  *       graph since no computation can purely be a function of its own result.
  */
-static void visit(DirectedGraph<Variable*>& graph, Variable& currentVar);
+template <typename T>
+static void visit(DirectedGraph<BasicVariable<T>*>& graph, BasicVariable<T>& currentVar,
+		  std::uint64_t stamp);
 
 #endif
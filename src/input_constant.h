@@ -4,6 +4,9 @@
 
 #include "Input.h"
 
-inline const Input input{};
+template <typename T>
+inline const BasicInput<T> basicInput{};
+
+inline const Input& input{ basicInput<double> };
 
 #endif
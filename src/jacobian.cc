@@ -0,0 +1,56 @@
+
+#include "jacobian.h"
+#include "forwardProp.h"
+#include "backProp.h"
+
+template <typename T>
+std::vector<std::vector<T>> jacobian(DirectedGraph<BasicVariable<T>*>& graph,
+				     const std::vector<BasicVariable<T>*>& inputs,
+				     const std::vector<BasicVariable<T>*>& outputs,
+				     JacobianMode mode)
+{
+  if (mode == JacobianMode::Automatic)
+    mode = (inputs.size() < outputs.size()) ? JacobianMode::Forward : JacobianMode::Reverse;
+
+  forwardProp(graph, outputs);
+  std::vector<std::vector<T>> result(outputs.size(), std::vector<T>(inputs.size(), T{0}));
+  if (mode == JacobianMode::Forward)
+    {
+      // Column j is the JVP with the j-th unit vector.
+      std::vector<T> tangents(inputs.size(), T{0});
+      for (std::size_t j{0}; j < inputs.size(); ++j)
+	{
+	  tangents[j] = T{1};
+	  const auto column{ forwardProp_jvp<T>(graph, inputs, tangents, outputs) };
+	  for (std::size_t i{0}; i < outputs.size(); ++i)
+	    result[i][j] = column[i];
+	  tangents[j] = T{0};
+	}
+    }
+  else
+    {
+      // Row i is the VJP with the i-th unit vector, which only needs output i seeded.
+      for (std::size_t i{0}; i < outputs.size(); ++i)
+	{
+	  const auto grad_table{ backProp_vjp(graph, std::vector<BasicVariable<T>*>{outputs[i]},
+					      std::vector<BasicGradient<T>>{ {T{1}} }) };
+	  for (std::size_t j{0}; j < inputs.size(); ++j)
+	    {
+	      const auto it{ grad_table.find(inputs[j]) };
+	      if (it != grad_table.end())
+		result[i][j] = it->second[0];
+	    }
+	}
+    }
+  return result;
+}
+
+template std::vector<std::vector<float>>
+jacobian(DirectedGraph<BasicVariable<float>*>&, const std::vector<BasicVariable<float>*>&,
+	 const std::vector<BasicVariable<float>*>&, JacobianMode);
+template std::vector<std::vector<double>>
+jacobian(DirectedGraph<BasicVariable<double>*>&, const std::vector<BasicVariable<double>*>&,
+	 const std::vector<BasicVariable<double>*>&, JacobianMode);
+template std::vector<std::vector<long double>>
+jacobian(DirectedGraph<BasicVariable<long double>*>&, const std::vector<BasicVariable<long double>*>&,
+	 const std::vector<BasicVariable<long double>*>&, JacobianMode);
@@ -0,0 +1,29 @@
+
+#ifndef JACOBIAN_H
+#define JACOBIAN_H
+
+#include "Variable.h"
+#include "DirectedGraph.h"
+#include <vector>
+
+/**
+ * @brief How the Jacobian is computed. Automatic picks forward mode when there are fewer
+ *        inputs than outputs, since that needs one sweep per input, and reverse otherwise.
+ */
+enum class JacobianMode { Automatic, Forward, Reverse };
+
+/**
+ * @brief Computes the Jacobian of the outputs w.r.t. the inputs.
+ * @param graph The computational graph. It is forward propagated first.
+ * @param inputs The scalar variables to differentiate with respect to.
+ * @param outputs The scalar variables to differentiate.
+ * @param mode Forward mode (one JVP per input) or reverse mode (one VJP per output).
+ * @return Row i holds the gradient of outputs[i], i.e. jacobian[i][j] = d out_i / d in_j.
+ */
+template <typename T>
+std::vector<std::vector<T>> jacobian(DirectedGraph<BasicVariable<T>*>& graph,
+				     const std::vector<BasicVariable<T>*>& inputs,
+				     const std::vector<BasicVariable<T>*>& outputs,
+				     JacobianMode mode=JacobianMode::Automatic);
+
+#endif
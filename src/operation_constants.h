@@ -13,13 +13,44 @@
 #include "ScalarLog.h"
 #include "ScalarAbs.h"
 
-inline const ScalarAdd scalarAdd{};
-inline const ScalarSub scalarSub{};
-inline const ScalarMul scalarMul{};
-inline const ScalarDiv scalarDiv{};
-inline const ScalarExp scalarExp{};
-inline const ScalarXpn scalarXpn{};
-inline const ScalarLog scalarLog{};
-inline const ScalarAbs scalarAbs{};
+// One instance of each operation per precision. Variables refer to these by reference.
+template <typename T> inline const BasicScalarAdd<T> basicScalarAdd{};
+template <typename T> inline const BasicScalarSub<T> basicScalarSub{};
+template <typename T> inline const BasicScalarMul<T> basicScalarMul{};
+template <typename T> inline const BasicScalarDiv<T> basicScalarDiv{};
+template <typename T> inline const BasicScalarExp<T> basicScalarExp{};
+template <typename T> inline const BasicScalarXpn<T> basicScalarXpn{};
+template <typename T> inline const BasicScalarLog<T> basicScalarLog{};
+template <typename T> inline const BasicScalarAbs<T> basicScalarAbs{};
+
+/**
+ * @brief The operation instance of an op code, i.e. to rebuild variables from a compact graph.
+ */
+template <typename T>
+inline const BasicOperation<T>& operationOf(OpCode code)
+{
+  switch (code)
+    {
+    case OpCode::Input: return basicInput<T>;
+    case OpCode::ScalarAdd: return basicScalarAdd<T>;
+    case OpCode::ScalarSub: return basicScalarSub<T>;
+    case OpCode::ScalarMul: return basicScalarMul<T>;
+    case OpCode::ScalarDiv: return basicScalarDiv<T>;
+    case OpCode::ScalarXpn: return basicScalarXpn<T>;
+    case OpCode::ScalarExp: return basicScalarExp<T>;
+    case OpCode::ScalarLog: return basicScalarLog<T>;
+    case OpCode::ScalarAbs: return basicScalarAbs<T>;
+    }
+  throw InvalidOperationException("Unknown op code.");
+}
+
+inline const ScalarAdd& scalarAdd{ basicScalarAdd<double> };
+inline const ScalarSub& scalarSub{ basicScalarSub<double> };
+inline const ScalarMul& scalarMul{ basicScalarMul<double> };
+inline const ScalarDiv& scalarDiv{ basicScalarDiv<double> };
+inline const ScalarExp& scalarExp{ basicScalarExp<double> };
+inline const ScalarXpn& scalarXpn{ basicScalarXpn<double> };
+inline const ScalarLog& scalarLog{ basicScalarLog<double> };
+inline const ScalarAbs& scalarAbs{ basicScalarAbs<double> };
 
 #endif